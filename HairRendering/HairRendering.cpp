@@ -14,9 +14,25 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/transform.hpp>
 #include <cmath>
+#include <chrono>
 #include "shader.h"
 #include "stb_image.h"
 #include "marschner_texture.h"
+#include "marschner_batch.h"
+#include "marschner_streaming.h"
+#include "marschner_compute.h"
+#include "marschner_fit.h"
+#include "hair_model.h"
+#include "hair_frames.h"
+#include "hair_benchmark.h"
+#include "hair_pack.h"
+#include "hair_streaming.h"
+#include "gpu_timer.h"
+#include "hair_culling.h"
+#include "hair_ribbons.h"
+#include "hair_raster.h"
+#include "shader_registry.h"
+#include "thread_pool.h"
 #include "imgui/imgui.h"
 #include "imgui/backends/imgui_impl_glfw.h"
 #include "imgui/backends/imgui_impl_opengl3.h"
@@ -101,185 +117,18 @@ void setupObjBuffers(OBJModel& model) {
 }
 
 
-void renderOBJ(GLuint shaderProgram, const mat4& MVP, const mat4& model, const OBJModel& modelData, const vec3& cameraPos, const vec3& lightPos) {
-    glUseProgram(shaderProgram);
-
-    GLuint MVPLoc = glGetUniformLocation(shaderProgram, "MVP");
-    glUniformMatrix4fv(MVPLoc, 1, GL_FALSE, value_ptr(MVP));
-
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    __glewUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(model));
-
-    GLuint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
-    glUniform3fv(lightPosLoc, 1, value_ptr(lightPos));
-
-    GLuint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-    glUniform3fv(viewPosLoc, 1, value_ptr(cameraPos));
+// MVP, model, lightPos, viewPos는 FrameData UBO에서 읽는다
+void renderOBJ(const ShaderUniforms& program, const OBJModel& modelData) {
+    glUseProgram(program.program());
 
     float gamma = 2.2f;
-    GLuint gammaLoc = glGetUniformLocation(shaderProgram, "gamma");
-    glUniform1f(gammaLoc, gamma);
+    program.set("gamma", gamma);
 
     glBindVertexArray(modelData.vao);
     glDrawElements(GL_TRIANGLES, modelData.indices.size(), GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
 
-struct HairVertex {
-    vec3 position;
-    vec3 uDirections;
-    vec3 vDirections;
-    vec3 wDirections;
-    float thickness;       
-    float transparency;   
-};
-
-struct HairStrand {
-    vector<HairVertex> vertices;
-};
-
-struct HairModel {
-    vector<HairStrand> strands;
-};
-
-void calculateUVWdirection(HairStrand& hairstrand) {
-    size_t n = hairstrand.vertices.size();
-    if (n < 2) return;
-
-    vec3 u(0.0f);
-
-    for (size_t i = 0; i < n - 1; i++) {
-        if (i == 0 && n > 1) {
-            vec3 p1 = vec3(hairstrand.vertices[i].position);
-            vec3 p2 = vec3(hairstrand.vertices[i + 1].position);
-            u = normalize(p2 - p1);
-        }
-        else if (i == n - 1 && n > 1) {
-            vec3 p1 = vec3(hairstrand.vertices[i - 1].position);
-            vec3 p2 = vec3(hairstrand.vertices[i].position);
-            u = normalize(p2 - p1);
-        }
-        else {
-            vec3 p1 = vec3(hairstrand.vertices[i - 1].position);
-            vec3 p2 = vec3(hairstrand.vertices[i + 1].position);
-            u = normalize(p2 - p1);
-        }
-        hairstrand.vertices[i].uDirections = u;
-
-        vec3 v;
-        if (fabs(u.x) > fabs(u.z)) {
-            v = normalize(vec3(-u.y, u.x, 0.0f));
-        } else {
-            v = normalize(vec3(0.0f, -u.z, u.y));  
-        }
-        vec3 w = normalize(cross(u, v));  
-
-        hairstrand.vertices[i].vDirections = v;
-        hairstrand.vertices[i].wDirections = w;
-    }
-}
-
-HairModel loadHairFile(const string& path) {
-    HairModel model;
-    ifstream file(path, ios::binary);
-    if (!file) {
-        std::cerr << "Cannot open .hair file" << std::endl;
-        return model;
-    }
-
-    // Header
-    char magic[4];
-    file.read(magic, 4);
-    if (strncmp(magic, "HAIR", 4) != 0) {
-        std::cerr << "Invalid .hair format" << std::endl;
-        return model;
-    }
-
-	// numStrand 4-7, numPoints 8-11, bitflags 12-15
-    uint32_t numStrands, numPoints, flags;
-    file.read((char*)&numStrands, 4);
-    file.read((char*)&numPoints, 4);
-    file.read((char*)&flags, 4);
-
-    bool hasSegments = flags & (1 << 0);
-    bool hasPoints = flags & (1 << 1);
-    bool hasThickness = flags & (1 << 2);
-    bool hasTransparency = flags & (1 << 3);
-    bool hasColor = flags & (1 << 4); // 일단 파싱만함. 사용 x
-
-    uint32_t defaultSegments;
-    float defaultThickness, defaultTransparency, defaultColor[3];
-    file.read((char*)&defaultSegments, 4);
-    file.read((char*)&defaultThickness, 4);
-    file.read((char*)&defaultTransparency, 4);
-    file.read((char*)defaultColor, sizeof(float) * 3);
-    file.ignore(88); // 파일정보 88바이트 무시
-
-    // Segments
-    vector<uint16_t> segments(numStrands);
-    if (hasSegments)
-        file.read((char*)segments.data(), sizeof(uint16_t) * numStrands);
-    else
-        fill(segments.begin(), segments.end(), defaultSegments);
-
-    // Points
-    vector<vec3> positions(numPoints);
-    if (hasPoints)
-        file.read((char*)positions.data(), sizeof(float) * 3 * numPoints);
-    else {
-        cerr << "No point data in .hair file" << endl;
-        return model;
-    }
-
-    // Thickness
-    std::vector<float> thickness(numPoints, defaultThickness);
-    if (hasThickness)
-        file.read((char*)thickness.data(), sizeof(float) * numPoints);
-
-    // Transparency 
-    std::vector<float> transparency(numPoints, defaultTransparency);
-    if (hasTransparency)
-        file.read((char*)transparency.data(), sizeof(float) * numPoints);
-
-    // Color 
-    std::vector<vec3> colors(numPoints, vec3(defaultColor[0], defaultColor[1], defaultColor[2]));
-    if (hasColor)
-        file.read((char*)colors.data(), sizeof(float) * 3 * numPoints);
-
-    // Build strands 
-    size_t offset = 0;
-    for (size_t i = 0; i < numStrands; ++i) {
-        uint16_t segs = segments[i];
-        HairStrand strand;
-
-        for (size_t j = 0; j <= segs; ++j) {
-            HairVertex v;
-            v.position = positions[offset];
-            v.thickness = thickness[offset];
-            v.transparency = transparency[offset];
-            // v.color = colors[offset];
-            //v.tipRatio = float(j) / float(segs);
-            strand.vertices.push_back(v);
-            ++offset;
-        }
-
-        calculateUVWdirection(strand);
-        model.strands.push_back(strand);
-    }
-
-    
-    // Rotate model for alignment
-    mat4 R = glm::rotate(mat4(1.0f), glm::radians(90.0f), vec3(1, 0, 0));
-    R = glm::rotate(R, glm::radians(90.0f), vec3(0, 1, 0));
-    for (auto& strand : model.strands) {
-        for (auto& v : strand.vertices) {
-            vec4 p = vec4(v.position, 1.0f);
-            v.position = vec3(R * p);
-        }
-    }
-    
-    return model;
-}
 /*
 GLuint objFBO, objColorTex, objDepthTex;
 void initObjFBO(GLuint& objFBO, GLuint& objColorTex, GLuint& objDepthTex, int width, int height) {
@@ -332,74 +181,9 @@ void initObjFBO(GLuint& objFBO, GLuint& objColorTex, GLuint& objDepthTex, int wi
 //    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 //}
 
-vec3 computeHairCenter(const HairModel& model) {
-    vec3 sum(0.0f); int cnt = 0;
-    for (const auto& s : model.strands)
-        for (const auto& v : s.vertices) sum += v.position, cnt++;
-    return cnt > 0 ? sum / float(cnt) : vec3(0);
-}
-
-
-GLuint hairVAO, hairVBO;
 //GLuint hairShadowVAO, hairShadowVBO;
 //GLuint hairAlphaVAO, hairAlphaVBO;
 
-void setupHairBuffers(const HairModel& hairModel) {
-    std::vector<float> hairVertexData;
-
-    for (const auto& strand : hairModel.strands) {
-        for (const auto& v : strand.vertices) {
-            hairVertexData.push_back(v.position.x);
-            hairVertexData.push_back(v.position.y);
-            hairVertexData.push_back(v.position.z);
-
-            hairVertexData.push_back(v.uDirections.x);
-            hairVertexData.push_back(v.uDirections.y);
-            hairVertexData.push_back(v.uDirections.z);
-
-            hairVertexData.push_back(v.vDirections.x);
-            hairVertexData.push_back(v.vDirections.y);
-            hairVertexData.push_back(v.vDirections.z);
-
-            hairVertexData.push_back(v.wDirections.x);
-            hairVertexData.push_back(v.wDirections.y);
-            hairVertexData.push_back(v.wDirections.z);
-
-            hairVertexData.push_back(v.thickness);
-            hairVertexData.push_back(v.transparency);
-        }
-    }
-
-    glGenVertexArrays(1, &hairVAO);
-    glGenBuffers(1, &hairVBO);
-
-    glBindVertexArray(hairVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, hairVBO);
-    glBufferData(GL_ARRAY_BUFFER, hairVertexData.size() * sizeof(float), hairVertexData.data(), GL_STATIC_DRAW);
-
-    GLsizei stride = 14 * sizeof(float);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(0));
-    glEnableVertexAttribArray(0); // position
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1); // u
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2); // v
-
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(9 * sizeof(float)));
-    glEnableVertexAttribArray(3); // w
-
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(12 * sizeof(float)));
-    glEnableVertexAttribArray(4); // thickness
-
-    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(13 * sizeof(float)));
-    glEnableVertexAttribArray(5); // transparency
-
-    glBindVertexArray(0);
-}
-
 //void setupShadowHairBuffers(const HairModel& hairModel) {
 //    std::vector<float> hairVertexData;
 //
@@ -453,37 +237,6 @@ void setupHairBuffers(const HairModel& hairModel) {
 //}
 
 
-void saveAsOBJ(const string& outPath, const vector<HairStrand>& strands) {
-    ofstream out(outPath);
-    if (!out.is_open()) {
-        cerr << "Failed to write OBJ file." << endl;
-        return;
-    }
-
-    int vertexOffset = 1;
-    for (const auto& strand : strands) {
-        for (const auto& v : strand.vertices) {
-            out << "v " << v.position.x << " " << v.position.y << " " << v.position.z << endl;
-        }
-
-        out << "l";
-        for (int i = 0; i < strand.vertices.size(); ++i) {
-            out << " " << vertexOffset + i;
-        }
-        out << endl;
-
-        vertexOffset += strand.vertices.size();
-    }
-
-    out.close();
-}
-
-HairModel convertStrandsToHairModel(const vector<HairStrand>& strands) {
-    HairModel model;
-    model.strands = strands;
-    return model;
-}
-
 /*
 GLuint fbo_depth_range;
 GLuint tex_depth_range;
@@ -579,7 +332,7 @@ void initAllFramebuffers(int width, int height)
 
 
 // *****Rendering Functions*****
-void renderShadowDepthMap(GLuint shader, const HairModel& hairModel, const mat4& MVP_light)
+void renderShadowDepthMap(GLuint shader, const HairDrawList& drawList, const mat4& MVP_light)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_shadowDepthRange);
     glViewport(0, 0, windowWidth, windowHeight);
@@ -597,11 +350,7 @@ void renderShadowDepthMap(GLuint shader, const HairModel& hairModel, const mat4&
 
     glBindVertexArray(hairShadowVAO);
 
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Shadow depth range", drawList);
     glBindVertexArray(0);
 
     glDisable(GL_BLEND);
@@ -612,7 +361,7 @@ void renderShadowDepthMap(GLuint shader, const HairModel& hairModel, const mat4&
 }
 
 
-void renderShadowOccupancy(GLuint shader, const HairModel& hairModel, const mat4& MVP_light, GLuint depthRangeTex)
+void renderShadowOccupancy(GLuint shader, const HairDrawList& drawList, const mat4& MVP_light, GLuint depthRangeTex)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_shadowOccupancy);
     glViewport(0, 0, windowWidth, windowHeight);
@@ -630,18 +379,14 @@ void renderShadowOccupancy(GLuint shader, const HairModel& hairModel, const mat4
     glUniform1i(glGetUniformLocation(shader, "depthRangeMap"), 0);
 
     glBindVertexArray(hairShadowVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Shadow occupancy", drawList);
     glBindVertexArray(0);
 
     glDisable(GL_BLEND);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void renderShadowSlab(GLuint shader, const HairModel& hairModel, const mat4& MVP_light, GLuint occupancyTex)
+void renderShadowSlab(GLuint shader, const HairDrawList& drawList, const mat4& MVP_light, GLuint occupancyTex)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_shadowSlab); 
     glViewport(0, 0, windowWidth, windowHeight);
@@ -663,11 +408,7 @@ void renderShadowSlab(GLuint shader, const HairModel& hairModel, const mat4& MVP
     glUniform1i(glGetUniformLocation(shader, "occupancyMap"), 0);
 
     glBindVertexArray(hairShadowVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Shadow slab", drawList);
     glBindVertexArray(0);
 
     glDisable(GL_BLEND);
@@ -702,7 +443,7 @@ void renderHeadDepthMap(GLuint depthOnlyShader, const OBJModel& headModel, const
 
 
 
-void renderDepthRange(GLuint shader, const HairModel& hairModel, const glm::mat4& MVP)
+void renderDepthRange(GLuint shader, const HairDrawList& drawList, const glm::mat4& MVP)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_depth_range);
     glViewport(0, 0, windowWidth, windowHeight);
@@ -721,11 +462,7 @@ void renderDepthRange(GLuint shader, const HairModel& hairModel, const glm::mat4
     glUniformMatrix4fv(glGetUniformLocation(shader, "MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
 
     glBindVertexArray(hairAlphaVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Depth range", drawList);
 
     glBindVertexArray(0);
     glDisable(GL_BLEND);
@@ -736,7 +473,7 @@ void renderDepthRange(GLuint shader, const HairModel& hairModel, const glm::mat4
 
 
 // PASS 2: Occupancy Map
-void renderOccupancy(GLuint shaderOccupancy, const HairModel& hairModel, const mat4& MVP_auto, float near, float far, GLuint tex_depth_range)
+void renderOccupancy(GLuint shaderOccupancy, const HairDrawList& drawList, const mat4& MVP_auto, float near, float far, GLuint tex_depth_range)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_occupancy);
     glViewport(0, 0, windowWidth, windowHeight);
@@ -762,11 +499,7 @@ void renderOccupancy(GLuint shaderOccupancy, const HairModel& hairModel, const m
     glUniform1i(glGetUniformLocation(shaderOccupancy, "depth_range_map"), 0);
 
     glBindVertexArray(hairAlphaVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Occupancy", drawList);
     glBindVertexArray(0);
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -777,7 +510,7 @@ void renderOccupancy(GLuint shaderOccupancy, const HairModel& hairModel, const m
 
 
 // PASS 3: Slab Map
-void renderSlabMap(GLuint shaderSlab, const HairModel& hairModel, const mat4& MVP, float near, float far, GLuint tex_occupancy)
+void renderSlabMap(GLuint shaderSlab, const HairDrawList& drawList, const mat4& MVP, float near, float far, GLuint tex_occupancy)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_slab);
     glViewport(0, 0, windowWidth, windowHeight);
@@ -812,11 +545,7 @@ void renderSlabMap(GLuint shaderSlab, const HairModel& hairModel, const mat4& MV
 
 
     glBindVertexArray(hairAlphaVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Slab map", drawList);
     glBindVertexArray(0);
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -862,7 +591,7 @@ void renderComposite(GLuint shaderComposite)
 */
 
 /*
-void renderHair(GLuint shaderProgram, const HairModel& hairModel, const mat4& MVP, const mat4& model, const vec3& cameraPos, const vec3& lightPos)
+void renderHair(GLuint shaderProgram, const HairDrawList& drawList, const mat4& MVP, const mat4& model, const vec3& cameraPos, const vec3& lightPos)
 {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -918,11 +647,7 @@ void renderHair(GLuint shaderProgram, const HairModel& hairModel, const mat4& MV
 
     // Draw hair strands
     glBindVertexArray(hairVAO);
-    int offset = 0;
-    for (const auto& strand : hairModel.strands) {
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    }
+    drawHairStrands("Hair", drawList);
     glBindVertexArray(0);
 
     glDepthMask(GL_TRUE);
@@ -931,44 +656,193 @@ void renderHair(GLuint shaderProgram, const HairModel& hairModel, const mat4& MV
 
 */
 
-void renderHair(GLuint shaderProgram, const mat4& MVP, const mat4& model, HairModel& hairmodel, const vec3& cameraPos, const vec3& lightPos) {
-   
-	//glEnable(GL_DEPTH_TEST);
-    //glDepthMask(GL_TRUE); 
-	//glDisable(GL_BLEND); 
-    glUseProgram(shaderProgram); 
-    GLuint MVPLoc = glGetUniformLocation(shaderProgram, "MVP"); 
-    glUniformMatrix4fv(MVPLoc, 1, GL_FALSE, value_ptr(MVP)); 
-    GLuint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos"); 
-    glUniform3fv(lightPosLoc, 1, value_ptr(lightPos)); 
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    __glewUniformMatrix4fv(modelLoc, 1, GL_FALSE, value_ptr(model)); 
-    GLuint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos"); 
-
-    glUniform3fv(viewPosLoc, 1, value_ptr(cameraPos)); 
+// 한 pass에서 hair를 제출하는 데 쓴 CPU 시간 (매 프레임 다시 채움)
+struct HairPassSubmit {
+    const char* pass;
+    double cpuMs;
+    size_t drawCalls;
+    size_t strands;
+};
+vector<HairPassSubmit> hairPassSubmits;
+bool perStrandDraws = false;    // 비교용: strand마다 glDrawArrays
+
+// 바인딩된 VAO로 drawList의 앞 strandCount개 strand를 한 번에 그린다
+void drawHairStrands(const char* pass, const HairDrawList& drawList, size_t strandCount = SIZE_MAX) {
+    strandCount = std::min(strandCount, drawList.size());
+    auto submitStart = chrono::steady_clock::now();
+    if (perStrandDraws) {
+        for (size_t s = 0; s < strandCount; ++s)
+            glDrawArrays(GL_LINE_STRIP, drawList.first[s], drawList.count[s]);
+    } else if (strandCount > 0) {
+        glMultiDrawArrays(GL_LINE_STRIP, drawList.first.data(), drawList.count.data(), GLsizei(strandCount));
+    }
+    double submitMs = chrono::duration<double, milli>(chrono::steady_clock::now() - submitStart).count();
+    hairPassSubmits.push_back({ pass, submitMs, perStrandDraws ? strandCount : size_t(1), strandCount });
+}
+
+float hairStrandFraction = 1.0f;    // 앞에서부터 이 비율의 strand만 그림 (벤치마크용 groom 크기)
+
+// hair를 그리는 방식. 기본은 vert -> frag line strip.
+// LinesGeometryShader는 hair_shader.geom (pass-through)을 거치고 (비교용),
+// Ribbons는 hair_ribbon.vert가 thickness 폭의 quad로 늘린다 (GL 4.3+).
+// Software는 hair_raster_*.comp가 tile별로 coverage를 계산한다 (GL 4.3+, sub-pixel strand용).
+enum class HairPrimitive { Lines, LinesGeometryShader, Ribbons, Software };
+const char* hairPrimitiveLabels[] = { "Lines", "Lines + pass-through GS", "Ribbons (vertex pulling)", "Software raster (compute)" };
+HairPrimitive hairPrimitive = HairPrimitive::Lines;
+float ribbonWidthScale = 1.0f;     // software raster도 같은 폭을 쓴다
+float ribbonMinPixels = 1.0f;
+bool rasterStageTimings = false;   // 단계마다 glFinish (llvmpipe는 GL_TIME_ELAPSED가 0). 켜면 프레임이 느려진다.
+
+// 이 context에서 고를 수 있는 primitive 수 (enum 순서대로)
+int availableHairPrimitives(const HairRibbons& ribbons, const HairRasterizer& rasterizer) {
+    if (!ribbons.available()) return 2;
+    return rasterizer.available() ? 4 : 3;
+}
+
+// 흡수 계수 σa. LUT에는 없고 셰이더에서 exp(-σa * L)로 곱하므로 바꿔도 LUT를 다시 만들지 않는다.
+vec3 hairAbsorption = vec3(0.44f, 0.64f, 0.9f); // brown
+//vec3 hairAbsorption = vec3(0.2f, 0.2f, 0.2f); // blond
+
+MarschnerLUTLayout lutLayout = MarschnerLUTLayout::Packed;
+const char* lutLayoutLabels[] = { "Separate (4 fetches)", "Packed (3 fetches)", "Fitted (no fetches)" };
+
+// 현재 LUT 파라미터. 슬라이더로 바꾸면 lutStreamer가 백그라운드에서 다시 만들어 교체한다.
+const int kLUTSize = 256;
+MarschnerParams lutParams;
+MarschnerLUTStreamer lutStreamer;
+MarschnerLUTCompute lutCompute;
+bool gpuLUTBuild = true;        // compute shader가 있으면 슬라이더 변경을 GPU에서 바로 만든다
+MarschnerComputeReport lutComputeReport;
+future<MarschnerComputeReport> lutComputePending;  // CPU 기준값 비교가 끝나기를 기다리는 중
+float lutShiftDegrees = -7.5f;  // alpha_R
+float lutWidthDegrees = 7.5f;   // beta_R
+
+// Fitted 모드 계수. 파라미터가 바뀌면 worker thread에서 다시 fit한다.
+MarschnerFit lutFit;
+MarschnerFitError lutFitError;  // 현재 흡수 기준, kLUTSize LUT와 비교
+future<pair<MarschnerFit, MarschnerFitError>> lutFitPending;
+bool lutFitStale = false;       // fit 중에 파라미터가 또 바뀜
+
+pair<MarschnerFit, MarschnerFitError> runMarschnerFit(MarschnerParams params, vec3 absorption) {
+    MarschnerFit fit = fitMarschnerN(params);
+    return { fit, measureMarschnerFitError(fit, params, kLUTSize, absorption) };
+}
+
+void requestMarschnerFit() {
+    if (lutFitPending.valid()) {
+        lutFitStale = true;
+        return;
+    }
+    lutFitStale = false;
+    lutFitPending = async(launch::async, runMarschnerFit, lutParams, hairAbsorption);
+}
+
+void updateMarschnerFit() {
+    if (!lutFitPending.valid() || lutFitPending.wait_for(chrono::seconds(0)) != future_status::ready)
+        return;
+    auto result = lutFitPending.get();
+    lutFit = result.first;
+    lutFitError = result.second;
+    cout << "[LUT] fitted N in " << lutFit.milliseconds << " ms, RMS error: NR " << lutFitError.rmsNR << ", TT "
+         << lutFitError.rmsTT << ", TRT " << lutFitError.rmsTRT << " (max " << lutFitError.maxNR << ", "
+         << lutFitError.maxTT << ", " << lutFitError.maxTRT << ")" << endl;
+    if (lutFitStale) requestMarschnerFit();
+}
+
+size_t drawnStrandCount(const HairModel& hairmodel) {
+    return size_t(hairmodel.strandCount() * double(hairStrandFraction));
+}
+
+// culler가 있으면 compute pass가 채운 indirect 명령으로 그린다.
+// 프레임 데이터는 FrameData UBO, sampler unit은 링크할 때 정해진다 (main의 bindSampler).
+// line/ribbon program이 같이 쓰는 LUT texture와 셰이딩 uniform
+void bindHairShading(const ShaderUniforms& program, const HairStreamer& hair) {
+    glUseProgram(program.program()); 
     glActiveTexture(GL_TEXTURE0); 
     glBindTexture(GL_TEXTURE_2D, marschnerTex); 
-    glUniform1i(glGetUniformLocation(shaderProgram, "marschnerTexture"), 0); 
     glActiveTexture(GL_TEXTURE1); glBindTexture(GL_TEXTURE_2D, NR_tex); 
-    glUniform1i(glGetUniformLocation(shaderProgram, "NR_texture"), 1);
     glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D, NTT_tex); 
-    glUniform1i(glGetUniformLocation(shaderProgram, "NTT_texture"), 2);
     glActiveTexture(GL_TEXTURE3); glBindTexture(GL_TEXTURE_2D, NTRT_tex); 
-    glUniform1i(glGetUniformLocation(shaderProgram, "NTRT_texture"), 3);
-
+    glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, N_tex);
+    glActiveTexture(GL_TEXTURE9); glBindTexture(GL_TEXTURE_2D, NL_tex);
+    program.set("lutLayout", int(lutLayout));
+    if (lutLayout == MarschnerLUTLayout::Fitted) {
+        program.set("fitCoefficients", lutFit.coefficients, kFitSegments * kFitTerms);
+        program.set("fitTRTPath", lutFit.trtPathCoefficients, kFitSegments * kFitTerms / 4);
+        // 백그라운드 fit이 끝날 때까지는 이전 계수를 쓰므로 lobe 값도 그 fit의 것을 쓴다
+        const MarschnerParams& fitted = lutFit.params;
+        program.set("lobeAlpha", vec3(fitted.alphaR, fitted.alphaTT, fitted.alphaTRT));
+        program.set("lobeBeta", vec3(fitted.betaR, fitted.betaTT, fitted.betaTRT));
+    }
+    program.set("absorption", hairAbsorption);
 
+    // 압축 정점이면 셰이더에서 cluster origin/scale로 복원
+    const HairVertexBuffer& buffer = hair.buffer();
+    glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_BUFFER, buffer.clusterTexture());
+    program.set("compactVertices", int(buffer.format() == HairVertexFormat::Compact));
+    program.set("thicknessScale", hair.current().compact.thicknessScale);
+}
 
-    glBindVertexArray(hairVAO); 
-    int offset = 0; 
-    for (const auto& strand : hairmodel.strands) { 
-        glDrawArrays(GL_LINE_STRIP, offset, strand.vertices.size());
-        offset += strand.vertices.size();
-    } 
+void renderHair(const ShaderUniforms& program, const HairStreamer& hair, HairCuller* culler) {
+   
+	//glEnable(GL_DEPTH_TEST);
+    //glDepthMask(GL_TRUE); 
+	//glDisable(GL_BLEND); 
+    bindHairShading(program, hair);
+
+    glBindVertexArray(hair.buffer().vao()); 
+    if (culler) {
+        auto submitStart = chrono::steady_clock::now();
+        culler->draw();
+        double submitMs = chrono::duration<double, milli>(chrono::steady_clock::now() - submitStart).count();
+        hairPassSubmits.push_back({ "Hair (indirect)", submitMs, 1, drawnStrandCount(hair.model()) });
+    } else {
+        drawHairStrands("Hair", hair.drawList(), drawnStrandCount(hair.model()));
+    }
 
 	//glDepthMask(GL_TRUE); // 깊이 버퍼 기록 활성화
 
 }
 
+// thickness 폭의 ribbon. VBO를 SSBO로 읽으므로 hair VAO는 쓰지 않는다.
+void renderHairRibbons(const ShaderUniforms& program, const HairStreamer& hair, HairRibbons& ribbons) {
+    bindHairShading(program, hair);
+    program.set("ribbonWidthScale", ribbonWidthScale);
+    program.set("ribbonMinPixels", ribbonMinPixels);
+
+    auto submitStart = chrono::steady_clock::now();
+    ribbons.draw(hair.buffer().vbo(), drawnStrandCount(hair.model()));
+    double submitMs = chrono::duration<double, milli>(chrono::steady_clock::now() - submitStart).count();
+    hairPassSubmits.push_back({ "Hair (ribbons)", submitMs, 1, drawnStrandCount(hair.model()) });
+}
+
+// ribbon과 같은 segment 목록을 compute shader로 rasterize한다. 셰이딩은 layout과 상관없이 packed LUT를 쓴다.
+void renderHairSoftware(GLuint resolveProgram, const HairStreamer& hair, const HairRibbons& ribbons,
+                        HairRasterizer& rasterizer, int width, int height) {
+    const HairVertexBuffer& buffer = hair.buffer();
+    glActiveTexture(GL_TEXTURE0); glBindTexture(GL_TEXTURE_2D, marschnerTex);
+    glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_BUFFER, buffer.clusterTexture());
+    glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, N_tex);
+    glActiveTexture(GL_TEXTURE9); glBindTexture(GL_TEXTURE_2D, NL_tex);
+    glActiveTexture(GL_TEXTURE0);
+
+    HairRasterParams params;
+    params.vertexBuffer = buffer.vbo();
+    params.compactVertices = buffer.format() == HairVertexFormat::Compact;
+    params.thicknessScale = hair.current().compact.thicknessScale;
+    params.widthScale = ribbonWidthScale;
+    params.absorption = hairAbsorption;
+    params.width = width;
+    params.height = height;
+    params.measureStages = rasterStageTimings;
+
+    // 단계 시간을 재면 glFinish가 들어가므로 submit 시간에 GPU 시간이 포함된다
+    auto submitStart = chrono::steady_clock::now();
+    rasterizer.draw(ribbons, drawnStrandCount(hair.model()), params, resolveProgram);
+    double submitMs = chrono::duration<double, milli>(chrono::steady_clock::now() - submitStart).count();
+    hairPassSubmits.push_back({ "Hair (software raster)", submitMs, 5, drawnStrandCount(hair.model()) });
+}
+
 
 float fov = 33.0f;
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
@@ -1023,8 +897,6 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
     }
 }
 
-const vec3 absorption = vec3(0.44, 0.64, 0.9); // brown
-//const vec3 absorption = vec3(0.2, 0.2, 0.2); // blond
 vector<vec3> predefinedAbsorptions = {
     vec3(0.1f, 0.1f, 0.1f),   // 밝은 금발
     vec3(0.25f, 0.15f, 0.1f), // 갈색
@@ -1041,7 +913,374 @@ string selectedHairFile = "../hairstyles/wCurly.hair";  // 기본 파일
 bool reloadHair = true;
 float lightPos[3] = {0.0f, 50.0f, 50.0f }; // 광원 초기 위치
 
-void showGUI(HairModel& hairModel) {
+HairFrameMode hairFrameMode = HairFrameMode::Axis;
+HairVertexFormat hairVertexFormat = HairVertexFormat::Full;
+const char* vertexFormatLabels[] = { "Full (56 B/vertex)", "Compact (16 B/vertex)" };
+
+// 성능 측정값 (GUI 표시용)
+double hairLoadMs = 0.0;
+bool hairLoadFromCache = false;
+double frameCpuMs = 0.0;
+double frameMs = 0.0;
+double loadMaxFrameMs = 0.0;   // 로드/업로드/교체 중 가장 긴 프레임
+int uploadBudgetMB = 8;         // 프레임당 GPU 업로드량
+HairFrameContinuity hairFrameContinuity;
+HairFrameContinuityCheck frameContinuityCheck;  // 시작할 때 합성 곱슬 strand로 한 번
+GpuTimer hairGpuTimer;
+GpuTimer cullGpuTimer;
+
+// 셰이더는 시작할 때 한 번 컴파일하고, 파일이 바뀐 것만 다시 컴파일한다
+ShaderRegistry shaderRegistry;
+FrameUniformBuffer frameUniformBuffer;
+double lutStartupMs = 0.0;
+bool lutStartupFromCache = false;
+double shaderStartupMs = 0.0;
+
+// LUT 생성 벤치마크: 크기마다 스레드 수를 1, 2, 4, ...로 늘려 가며 CPU 계산 시간을 잰다.
+// 같은 방식으로 frame builder (합성 groom)도 잰다. worker thread에서 돌리고 GUI는 끝난 결과만 보여준다.
+struct LUTBenchmarkRow {
+    int size;
+    unsigned threads;
+    LUTTimings timings;
+};
+struct LUTBenchmarkResult {
+    MarschnerBatchReport batch;     // batch 커널 vs 스칼라 코드
+    LUTCacheTimings cache;          // kLUTSize, cold / warm
+    vector<LUTBenchmarkRow> rows;
+    HairFrameBenchmark frames;
+};
+future<LUTBenchmarkResult> lutBenchmarkPending;
+LUTBenchmarkResult lutBenchmark;
+
+LUTBenchmarkResult runLUTBenchmark(MarschnerParams params) {
+    LUTBenchmarkResult result;
+    MarschnerBatchReport& batch = result.batch;
+    batch = validateMarschnerBatch(256, 1.55f);
+    (batch.passed() ? cout : cerr) << "[Benchmark] LUT kernels (" << batch.kernel << ", "
+         << (batch.passed() ? "pass" : "FAIL") << "): cubic " << batch.scalarCubicMs << " -> " << batch.batchCubicMs
+         << " ms (x" << batch.cubicSpeedup() << "), Fresnel " << batch.scalarFresnelMs << " -> " << batch.batchFresnelMs
+         << " ms (x" << batch.fresnelSpeedup() << "), max error: gamma " << batch.maxGammaError << ", Fresnel "
+         << batch.maxFresnelError << ", mismatches " << batch.rootMismatches + batch.fresnelMismatches
+         << " / " << batch.samples << endl;
+
+    result.cache = timeLUTCache(kLUTSize, params);
+    cout << "[Benchmark] LUT cache " << kLUTSize << "^2: cold " << result.cache.cold << " ms, warm "
+         << result.cache.warm << " ms" << endl;
+
+    vector<LUTBenchmarkRow>& rows = result.rows;
+    unsigned maxThreads = ThreadPool::global().threadCount();
+    for (int size : { 256, 512, 1024 }) {
+        for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+            LUTBenchmarkRow row = { size, threads, timeLUTGeneration(size, threads, params) };
+            rows.push_back(row);
+            cout << "[Benchmark] LUT " << size << "^2, " << threads << " threads: M " << row.timings.M
+                 << " ms, NR " << row.timings.NR << " ms, NTT " << row.timings.NTT << " ms, NTRT "
+                 << row.timings.NTRT << " ms, total " << row.timings.total() << " ms" << endl;
+            if (threads == maxThreads) break;
+        }
+    }
+
+    HairFrameBenchmark& frames = result.frames;
+    frames = benchmarkHairFrames(20000, 64);
+    cout << "[Benchmark] frames, " << frames.vertices << " vertices: calculateUVWdirection "
+         << frames.legacyVerticesPerSecond() / 1e6 << " Mverts/s" << (frames.identical ? "" : ", SIMD != scalar") << endl;
+    for (const HairFrameBenchmarkRow& row : frames.rows) {
+        cout << "[Benchmark] frames (" << (row.mode == HairFrameMode::ParallelTransport ? "parallel transport" : "axis")
+             << "), " << row.stats.kernel << " x " << row.stats.threads << " threads: " << row.stats.milliseconds << " ms, "
+             << row.stats.verticesPerSecondPerCore(frames.vertices) / 1e6 << " Mverts/s/core" << endl;
+    }
+    return result;
+}
+
+const char* benchmarkGrooms[] = {
+    "../hairstyles/wStraight.hair", "../hairstyles/wWavy.hair", "../hairstyles/wWavyThin.hair", "../hairstyles/wCurly.hair"
+};
+
+// .hair 로드 벤치마크.
+// 수 GB짜리 합성 groom을 써 두고 예전 ifstream 로더와 매핑 로더로 읽은 뒤,
+// 배포 groom마다 예전 AoS 모델과 지금의 SoA 모델을 만들어 로드 시간, 메모리, CPU walk를 비교한다.
+const char* kSyntheticGroomPath = "synthetic_groom.hair.bench";
+float loadBenchmarkGigabytes = 2.0f;
+
+struct LoadBenchmarkRow {
+    const char* groom;
+    HairModelTimings timings;
+};
+struct LoadBenchmarkResult {
+    HairReadTimings read;
+    vector<LoadBenchmarkRow> rows;
+    vector<const char*> skipped;    // 파일이 없는 groom
+};
+future<LoadBenchmarkResult> loadBenchmarkPending;
+LoadBenchmarkResult loadBenchmark;
+
+LoadBenchmarkResult runHairLoadBenchmark(float gigabytes) {
+    LoadBenchmarkResult result;
+    HairReadTimings& read = result.read;
+    if (writeSyntheticHairFile(kSyntheticGroomPath, uint64_t(gigabytes * 1e9), 31))
+        read = timeHairFileRead(kSyntheticGroomPath);
+    remove(kSyntheticGroomPath);
+
+    cout << "[Benchmark] .hair read, " << read.bytes / 1e9 << " GB (" << read.points << " points): ifstream "
+         << read.ifstreamMs << " ms (" << HairReadTimings::gbPerSecond(read.bytes, read.ifstreamMs)
+         << " GB/s), mapped " << read.mappedMs << " ms (" << HairReadTimings::gbPerSecond(read.bytes, read.mappedMs)
+         << " GB/s)" << (read.matched ? "" : ", checksum mismatch") << endl;
+
+    for (const char* groom : benchmarkGrooms) {
+        LoadBenchmarkRow row = { groom, timeHairModels(groom) };
+        if (row.timings.vertices == 0) {
+            result.skipped.push_back(groom);
+            continue;
+        }
+        const HairModelTimings& t = row.timings;
+        cout << "[Benchmark] " << groom << " (" << t.vertices << " vertices): load " << t.aosLoadMs << " -> " << t.soaLoadMs
+             << " ms, memory " << t.aosBytes / (1024.0 * 1024.0) << " MB in " << t.aosAllocations << " allocations -> "
+             << t.soaBytes / (1024.0 * 1024.0) << " MB, walk " << t.aosWalkMs << " -> " << t.soaWalkMs << " ms" << endl;
+        result.rows.push_back(row);
+    }
+    return result;
+}
+bool gpuCulling = true;
+float cullMinPixels = 1.0f;     // 화면상 지름이 이보다 작은 strand는 버림
+
+// 정점 형식 대역폭 벤치마크.
+// 형식마다 hair를 다시 올리고, 그리는 strand 비율(= groom 크기)마다 hair pass 시간을 평균낸다.
+struct BandwidthBenchmarkRow {
+    HairVertexFormat format;
+    float strandFraction;
+    size_t vertices;
+    double gpuMs;
+    double frameMs;
+    size_t drawnBytes;      // 그린 정점 데이터 크기
+    size_t gpuBytes;        // hair 버퍼 전체 (hairGpuMemory)
+};
+
+struct BandwidthBenchmark {
+    bool running = false;
+    int formatIndex = 0;
+    int sizeIndex = 0;
+    int frame = 0;
+    double gpuMsSum = 0.0;
+    double frameMsSum = 0.0;
+    HairVertexFormat savedFormat = HairVertexFormat::Full;
+    vector<BandwidthBenchmarkRow> rows;
+};
+
+const HairVertexFormat benchmarkFormats[] = { HairVertexFormat::Full, HairVertexFormat::Compact };
+const float benchmarkFractions[] = { 0.25f, 0.5f, 1.0f };
+const int benchmarkWarmupFrames = 8;    // GpuTimer 지연 + 교체 직후 프레임
+const int benchmarkFrames = 60;
+BandwidthBenchmark bandwidthBenchmark;
+
+void startBandwidthBenchmark() {
+    BandwidthBenchmark& bench = bandwidthBenchmark;
+    if (bench.running) return;
+    bench = BandwidthBenchmark();
+    bench.running = true;
+    bench.savedFormat = hairVertexFormat;
+}
+
+void updateBandwidthBenchmark(HairStreamer& hairStreamer) {
+    BandwidthBenchmark& bench = bandwidthBenchmark;
+    if (!bench.running || hairStreamer.busy()) return;
+
+    HairVertexFormat format = benchmarkFormats[bench.formatIndex];
+    if (hairStreamer.current().format != format) {
+        hairVertexFormat = format;
+        hairStreamer.request(selectedHairFile, hairFrameMode, format);
+        return;
+    }
+
+    hairStrandFraction = benchmarkFractions[bench.sizeIndex];
+    if (bench.frame++ < benchmarkWarmupFrames) return;
+    bench.gpuMsSum += hairGpuTimer.milliseconds();
+    bench.frameMsSum += frameMs;
+    if (bench.frame < benchmarkWarmupFrames + benchmarkFrames) return;
+
+    const HairModel& hairModel = hairStreamer.model();
+    BandwidthBenchmarkRow row;
+    row.format = format;
+    row.strandFraction = hairStrandFraction;
+    row.vertices = hairModel.strandOffsets.empty() ? 0 : hairModel.strandOffsets[drawnStrandCount(hairModel)];
+    row.gpuMs = bench.gpuMsSum / benchmarkFrames;
+    row.frameMs = bench.frameMsSum / benchmarkFrames;
+    row.drawnBytes = row.vertices * hairVertexStride(format);
+    row.gpuBytes = hairGpuMemory().bytes;
+    bench.rows.push_back(row);
+
+    bench.frame = 0;
+    bench.gpuMsSum = bench.frameMsSum = 0.0;
+    if (++bench.sizeIndex < IM_ARRAYSIZE(benchmarkFractions)) return;
+    bench.sizeIndex = 0;
+    if (++bench.formatIndex < IM_ARRAYSIZE(benchmarkFormats)) return;
+
+    bench.running = false;
+    hairStrandFraction = 1.0f;
+    if (hairVertexFormat != bench.savedFormat) {
+        hairVertexFormat = bench.savedFormat;
+        reloadHair = true;
+    }
+
+    cout << "[Benchmark] vertex format bandwidth (" << selectedHairFile << ")" << endl;
+    for (const BandwidthBenchmarkRow& r : bench.rows) {
+        cout << "  " << vertexFormatLabels[int(r.format)] << ", " << r.strandFraction * 100.0f << "% strands, "
+             << r.vertices << " vertices: hair GPU " << r.gpuMs << " ms, frame " << r.frameMs << " ms, "
+             << r.drawnBytes / (1024.0 * 1024.0) << " MB drawn, " << r.gpuBytes / (1024.0 * 1024.0) << " MB VRAM" << endl;
+    }
+}
+
+// LUT 배치 벤치마크: 같은 groom을 배치마다 benchmarkFrames 동안 그려 hair pass 시간을 평균낸다.
+struct LUTLayoutBenchmarkRow {
+    MarschnerLUTLayout layout;
+    double gpuMs;
+    double frameMs;
+};
+
+struct LUTLayoutBenchmark {
+    bool running = false;
+    int layoutIndex = 0;
+    int frame = 0;
+    double gpuMsSum = 0.0;
+    double frameMsSum = 0.0;
+    MarschnerLUTLayout savedLayout = MarschnerLUTLayout::Packed;
+    vector<LUTLayoutBenchmarkRow> rows;
+};
+
+const MarschnerLUTLayout benchmarkLayouts[] = { MarschnerLUTLayout::Separate, MarschnerLUTLayout::Packed, MarschnerLUTLayout::Fitted };
+LUTLayoutBenchmark lutLayoutBenchmark;
+
+void startLUTLayoutBenchmark() {
+    LUTLayoutBenchmark& bench = lutLayoutBenchmark;
+    if (bench.running) return;
+    bench = LUTLayoutBenchmark();
+    bench.running = true;
+    bench.savedLayout = lutLayout;
+}
+
+void updateLUTLayoutBenchmark(const HairStreamer& hairStreamer) {
+    LUTLayoutBenchmark& bench = lutLayoutBenchmark;
+    if (!bench.running || hairStreamer.busy()) return;
+
+    lutLayout = benchmarkLayouts[bench.layoutIndex];
+    if (bench.frame++ < benchmarkWarmupFrames) return;
+    bench.gpuMsSum += hairGpuTimer.milliseconds();
+    bench.frameMsSum += frameMs;
+    if (bench.frame < benchmarkWarmupFrames + benchmarkFrames) return;
+
+    bench.rows.push_back({ lutLayout, bench.gpuMsSum / benchmarkFrames, bench.frameMsSum / benchmarkFrames });
+    bench.frame = 0;
+    bench.gpuMsSum = bench.frameMsSum = 0.0;
+    if (++bench.layoutIndex < IM_ARRAYSIZE(benchmarkLayouts)) return;
+
+    bench.running = false;
+    lutLayout = bench.savedLayout;
+
+    cout << "[Benchmark] LUT layout (" << selectedHairFile << ", " << hairStreamer.model().vertexCount() << " vertices)" << endl;
+    for (const LUTLayoutBenchmarkRow& r : bench.rows)
+        cout << "  " << lutLayoutLabels[int(r.layout)] << ": hair GPU " << r.gpuMs << " ms, frame " << r.frameMs << " ms" << endl;
+}
+
+// hair primitive 벤치마크: 기본 groom마다 line, line + GS, ribbon, software raster로 benchmarkFrames 동안 그려
+// hair pass 시간을 평균낸다. segment 수 기준 처리량도 본다.
+struct HairPrimitiveBenchmarkRow {
+    const char* groom;
+    HairPrimitive primitive;
+    size_t vertices;
+    size_t segments;
+    double gpuMs;
+    double frameMs;
+};
+
+struct HairPrimitiveBenchmark {
+    bool running = false;
+    bool loading = false;       // groom 로드를 요청하고 교체를 기다리는 중
+    int groomIndex = 0;
+    int modeIndex = 0;
+    int modes = 0;              // availableHairPrimitives()
+    int frame = 0;
+    double gpuMsSum = 0.0;
+    double frameMsSum = 0.0;
+    HairPrimitive savedPrimitive = HairPrimitive::Lines;
+    bool savedStageTimings = false;
+    vector<HairPrimitiveBenchmarkRow> rows;
+    vector<const char*> skipped;    // 읽지 못한 groom
+};
+
+const HairPrimitive benchmarkPrimitives[] = {
+    HairPrimitive::Lines, HairPrimitive::LinesGeometryShader, HairPrimitive::Ribbons, HairPrimitive::Software
+};
+HairPrimitiveBenchmark hairPrimitiveBenchmark;
+
+void startHairPrimitiveBenchmark(int primitives) {
+    HairPrimitiveBenchmark& bench = hairPrimitiveBenchmark;
+    if (bench.running) return;
+    bench = HairPrimitiveBenchmark();
+    bench.running = true;
+    bench.modes = primitives;
+    bench.savedPrimitive = hairPrimitive;
+    bench.savedStageTimings = rasterStageTimings;
+}
+
+void finishHairPrimitiveBenchmark() {
+    HairPrimitiveBenchmark& bench = hairPrimitiveBenchmark;
+    bench.running = false;
+    hairPrimitive = bench.savedPrimitive;
+    rasterStageTimings = bench.savedStageTimings;
+    reloadHair = true;
+
+    cout << "[Benchmark] hair primitive" << endl;
+    for (const HairPrimitiveBenchmarkRow& r : bench.rows)
+        cout << "  " << r.groom << " (" << r.vertices << " vertices), " << hairPrimitiveLabels[int(r.primitive)]
+             << ": hair GPU " << r.gpuMs << " ms (" << (r.gpuMs > 0.0 ? r.segments / (r.gpuMs * 1e3) : 0.0)
+             << " M segments/s), frame " << r.frameMs << " ms" << endl;
+    for (const char* groom : bench.skipped)
+        cout << "  " << groom << ": not loaded, skipped" << endl;
+}
+
+void updateHairPrimitiveBenchmark(HairStreamer& hairStreamer) {
+    HairPrimitiveBenchmark& bench = hairPrimitiveBenchmark;
+    if (!bench.running) return;
+    // software raster의 단계별 glFinish가 다른 방식과의 비교를 흐리지 않도록 끈다
+    rasterStageTimings = false;
+    if (hairStreamer.busy()) return;
+
+    const char* groom = benchmarkGrooms[bench.groomIndex];
+    if (!bench.loading && bench.modeIndex == 0 && bench.frame == 0) {
+        bench.loading = hairStreamer.request(groom, hairFrameMode, hairVertexFormat);
+        return;
+    }
+    bench.loading = false;
+
+    // 읽지 못한 groom (파일 없음 등)은 건너뛴다. 이전 groom이나 빈 모델을 이 이름으로 재지 않도록.
+    if (bench.modeIndex == 0 && bench.frame == 0 &&
+        (hairStreamer.current().path != groom || hairStreamer.model().vertexCount() == 0)) {
+        cerr << "[Benchmark] " << groom << " did not load, skipping it" << endl;
+        bench.skipped.push_back(groom);
+        if (++bench.groomIndex < IM_ARRAYSIZE(benchmarkGrooms)) return;
+        finishHairPrimitiveBenchmark();
+        return;
+    }
+
+    hairPrimitive = benchmarkPrimitives[bench.modeIndex];
+    if (bench.frame++ < benchmarkWarmupFrames) return;
+    bench.gpuMsSum += hairGpuTimer.milliseconds();
+    bench.frameMsSum += frameMs;
+    if (bench.frame < benchmarkWarmupFrames + benchmarkFrames) return;
+
+    const HairModel& hairModel = hairStreamer.model();
+    size_t vertices = hairModel.vertexCount();
+    bench.rows.push_back({ groom, hairPrimitive, vertices, vertices - std::min(vertices, hairModel.strandCount()),
+                           bench.gpuMsSum / benchmarkFrames, bench.frameMsSum / benchmarkFrames });
+    bench.frame = 0;
+    bench.gpuMsSum = bench.frameMsSum = 0.0;
+    if (++bench.modeIndex < bench.modes) return;
+    bench.modeIndex = 0;
+    if (++bench.groomIndex < IM_ARRAYSIZE(benchmarkGrooms)) return;
+    finishHairPrimitiveBenchmark();
+}
+
+void showGUI(const HairModel& hairModel, const HairStreamer& hairStreamer, const HairCuller& culler, const HairRibbons& ribbons,
+             const HairRasterizer& rasterizer) {
     ImGui::Begin("Hair Rendering Controls");
     ImGui::SetWindowFontScale(2.0f);
     // LightPos 조정 슬라이더
@@ -1058,17 +1297,229 @@ void showGUI(HairModel& hairModel) {
         selectedHairFile = std::string(fileInputBuffer);
         reloadHair = true;
     }
-    GLuint Hair_shaderProgram = loadShaders("hair_shader.vert", "hair_shader.frag", "hair_shader.geom");
+    bool useParallelTransport = hairFrameMode == HairFrameMode::ParallelTransport;
+    if (ImGui::Checkbox("Rotation-minimizing frames", &useParallelTransport)) {
+        hairFrameMode = useParallelTransport ? HairFrameMode::ParallelTransport : HairFrameMode::Axis;
+        reloadHair = true;
+    }
+    int vertexFormatIndex = int(hairVertexFormat);
+    if (ImGui::Combo("Vertex format", &vertexFormatIndex, vertexFormatLabels, IM_ARRAYSIZE(vertexFormatLabels))) {
+        hairVertexFormat = HairVertexFormat(vertexFormatIndex);
+        reloadHair = true;
+    }
 
+    // 흡수는 셰이더 uniform이라 색을 바꿔도 LUT는 그대로
     if (ImGui::Combo("Hair Absorption", &selectedAbsorptionIndex, absorptionLabels, IM_ARRAYSIZE(absorptionLabels))) {
-        vec3 selectedAbsorption = predefinedAbsorptions[selectedAbsorptionIndex];
-
-        // Re-generate the textures
-        if (NTT_tex) glDeleteTextures(1, &NTT_tex);
-        if (NTRT_tex) glDeleteTextures(1, &NTRT_tex);
+        hairAbsorption = predefinedAbsorptions[selectedAbsorptionIndex];
+    }
+    ImGui::DragFloat3("Absorption", value_ptr(hairAbsorption), 0.01f, 0.0f, 5.0f);
+
+    int lutLayoutIndex = int(lutLayout);
+    if (ImGui::Combo("LUT Layout", &lutLayoutIndex, lutLayoutLabels, IM_ARRAYSIZE(lutLayoutLabels)))
+        lutLayout = MarschnerLUTLayout(lutLayoutIndex);
+
+    // 계산하는 동안은 이전 LUT로 그린다
+    bool lutChanged = ImGui::SliderFloat("Eta", &lutParams.eta, 1.2f, 2.0f);
+    lutChanged |= ImGui::SliderFloat("Shift (deg)", &lutShiftDegrees, -10.0f, 0.0f);
+    lutChanged |= ImGui::SliderFloat("Width (deg)", &lutWidthDegrees, 2.0f, 20.0f);
+    if (lutChanged) {
+        float eta = lutParams.eta;
+        lutParams = MarschnerParams::withShift(radians(lutShiftDegrees), radians(lutWidthDegrees));
+        lutParams.eta = eta;
+        // CPU 결과가 아직 올라오는 중이면 나중에 덮어쓰지 않도록 그쪽으로 보낸다
+        if (gpuLUTBuild && lutCompute.available() && !lutStreamer.busy())
+            lutCompute.build(kLUTSize, lutParams);
+        else
+            lutStreamer.request(kLUTSize, lutParams);
+        requestMarschnerFit();
+    }
+    if (lutCompute.available()) {
+        ImGui::Checkbox("GPU LUT build", &gpuLUTBuild);
+        ImGui::SameLine();
+        bool validating = lutComputePending.valid();
+        if (validating && lutComputePending.wait_for(chrono::seconds(0)) == future_status::ready) {
+            lutComputeReport = lutComputePending.get();
+            validating = false;
+            cout << "[LUT] GPU " << lutComputeReport.size << "^2: " << lutComputeReport.gpuMs << " ms (CPU "
+                 << lutComputeReport.cpuMs << " ms), "
+                 << lutComputeReport.mismatches << " + " << lutComputeReport.nanMismatches << " NaN mismatches / "
+                 << lutComputeReport.values << " (" << lutComputeReport.neighbourMatches << " at root boundaries), caustic "
+                 << lutComputeReport.causticMismatches << " / "
+                 << lutComputeReport.causticValues << ", max error " << lutComputeReport.maxError << endl;
+        }
+        if (ImGui::Button(validating ? "Validating..." : "Validate GPU LUT") && !validating)
+            lutComputePending = lutCompute.validate(1024, lutParams);
+        if (lutComputeReport.size > 0)
+            ImGui::Text("GPU LUT %d^2: %.1f ms (CPU %.1f ms), %s, %zu mismatches, max error %.4f", lutComputeReport.size,
+                        lutComputeReport.gpuMs, lutComputeReport.cpuMs, lutComputeReport.passed() ? "pass" : "FAIL",
+                        lutComputeReport.mismatches + lutComputeReport.nanMismatches + lutComputeReport.causticMismatches,
+                        lutComputeReport.maxError);
+    }
+    if (lutStreamer.busy())
+        ImGui::Text("LUT: rebuilding...");
+    else if (lutStreamer.lastLatencyMs() > 0.0)
+        ImGui::Text("LUT: %s %.1f ms, swapped after %.1f ms", lutStreamer.lastFromCache() ? "cache" : "build",
+                    lutStreamer.lastBuildMs(), lutStreamer.lastLatencyMs());
+
+    ImGui::Text("Performance:");
+    ImGui::Text("Strands: %zu, Vertices: %zu", hairModel.strandCount(), hairModel.vertexCount());
+    ImGui::Text("Hair CPU memory: %.2f MB", hairModel.memoryBytes() / (1024.0 * 1024.0));
+    const HairGpuMemory& gpuMemory = hairGpuMemory();
+    ImGui::Text("Hair GPU memory: %.2f MB (%zu buffers, %zu allocations)",
+                gpuMemory.bytes / (1024.0 * 1024.0), gpuMemory.bufferObjects, gpuMemory.allocations);
+    ImGui::Text("Hair load: %.2f ms (%s)", hairLoadMs, hairLoadFromCache ? "warm, .hairpack" : "cold");
+    ImGui::SliderInt("Upload budget (MB/frame)", &uploadBudgetMB, 1, 64);
+    if (hairStreamer.loading())
+        ImGui::Text("Loading %s...", selectedHairFile.c_str());
+    else if (hairStreamer.busy())
+        ImGui::Text("Uploading: %.0f%%", hairStreamer.uploadProgress() * 100.0f);
+    else
+        ImGui::Text("Upload: %d frames", hairStreamer.uploadFrames());
+    ImGui::Text("Max frame during load: %.2f ms", loadMaxFrameMs);
+    ImGui::Text("Frame CPU: %.3f ms (frame %.2f ms)", frameCpuMs, frameMs);
+    ImGui::Text("Hair GPU: %.3f ms", hairGpuTimer.milliseconds());
+    // 예전에는 hair program 컴파일+링크 (last compile)를 매 프레임 했다
+    const ShaderRegistryStats& shaderStats = shaderRegistry.stats();
+    ImGui::Text("Shaders: %d programs, %d compiles (last %.2f ms), %d cache hits, poll %.3f ms",
+                shaderStats.programs, shaderStats.compiles, shaderStats.lastCompileMs,
+                shaderStats.cacheHits, shaderStats.lastPollMs);
+    ImGui::Text("Hot reloads: %d, failed: %d%s%s", shaderStats.reloads, shaderStats.failures,
+                shaderStats.lastError.empty() ? "" : ", last error in ", shaderStats.lastError.c_str());
+    if (ImGui::Button("Reload shaders"))
+        shaderRegistry.reloadAll();
+    // 예전 경로: 매 프레임 uniform 20개 (fitted면 23개)를 이름으로 찾고 하나씩 올렸다
+    ImGui::Text("Uniform calls/frame: %u location queries, %u glUniform, %u UBO uploads",
+                uniformCallStats.locationQueries, uniformCallStats.uniformCalls, uniformCallStats.bufferUploads);
+    ImGui::Checkbox("Query uniform locations every call", &uniformLookupEveryCall);
+    ImGui::Checkbox("Per-strand draw calls", &perStrandDraws);
+    int primitiveIndex = int(hairPrimitive);
+    if (ImGui::Combo("Hair primitive", &primitiveIndex, hairPrimitiveLabels, availableHairPrimitives(ribbons, rasterizer)))
+        hairPrimitive = HairPrimitive(primitiveIndex);
+    if (hairPrimitive == HairPrimitive::Ribbons) {
+        ImGui::SliderFloat("Ribbon width scale", &ribbonWidthScale, 0.1f, 20.0f, "%.1f");
+        ImGui::SliderFloat("Ribbon min width (px)", &ribbonMinPixels, 0.0f, 4.0f);
+        ImGui::Text("Ribbon segments: %zu (%zu triangles)", ribbons.drawnSegments(), ribbons.drawnSegments() * 2);
+    }
+    if (hairPrimitive == HairPrimitive::Software) {
+        const HairRasterStats& raster = rasterizer.stats();
+        const HairRasterTimings& stages = rasterizer.timings();
+        ImGui::SliderFloat("Ribbon width scale", &ribbonWidthScale, 0.1f, 20.0f, "%.1f");
+        ImGui::Text("Raster: %zu segments, %dx%d tiles, %u tile entries, %u overflowed",
+                    raster.segments, raster.tilesX, raster.tilesY, raster.entries, raster.overflow);
+        ImGui::Checkbox("Per-stage timings (glFinish)", &rasterStageTimings);
+        if (rasterStageTimings) {
+            ImGui::Text("Setup %.3f, scan %.3f, bin %.3f, raster %.3f, resolve %.3f ms (total %.3f ms)",
+                        stages.setupMs, stages.scanMs, stages.binMs, stages.rasterMs, stages.resolveMs, stages.total());
+        }
+    }
+    if (culler.available()) {
+        ImGui::Checkbox("GPU culling (indirect draw)", &gpuCulling);
+        ImGui::SliderFloat("Min strand size (px)", &cullMinPixels, 0.0f, 16.0f);
+        if (gpuCulling) {
+            const HairCullStats& cull = culler.stats();
+            ImGui::Text("Strands drawn %u, frustum culled %u, size culled %u (cull GPU %.3f ms)",
+                        cull.drawn, cull.frustumCulled, cull.sizeCulled, cullGpuTimer.milliseconds());
+        }
+    } else {
+        ImGui::Text("GPU culling: needs OpenGL 4.3");
+    }
+    for (const HairPassSubmit& submit : hairPassSubmits) {
+        ImGui::Text("%s submit: %.3f ms CPU (%zu calls, %zu strands)",
+                    submit.pass, submit.cpuMs, submit.drawCalls, submit.strands);
+    }
+    if (hairStreamer.current().format == HairVertexFormat::Compact) {
+        const HairCompactError& error = hairStreamer.current().compactError;
+        ImGui::Text("Compact error: position %.5f, u %.3f deg, v %.3f deg", error.position, error.tangentDegrees, error.frameDegrees);
+    }
 
-        NTT_tex = createNTT_Texture(size, eta, selectedAbsorption);
-        NTRT_tex = createNTRT_Texture(size, eta, selectedAbsorption);
+    if (ImGui::Button(bandwidthBenchmark.running ? "Benchmark running..." : "Run bandwidth benchmark"))
+        startBandwidthBenchmark();
+    for (const BandwidthBenchmarkRow& r : bandwidthBenchmark.rows) {
+        ImGui::Text("%s %3.0f%%: %zu verts, GPU %.3f ms, frame %.2f ms, %.1f MB drawn, %.1f MB VRAM",
+                    vertexFormatLabels[int(r.format)], r.strandFraction * 100.0f, r.vertices, r.gpuMs, r.frameMs,
+                    r.drawnBytes / (1024.0 * 1024.0), r.gpuBytes / (1024.0 * 1024.0));
+    }
+    if (ImGui::Button(lutLayoutBenchmark.running ? "LUT layout benchmark running..." : "Run LUT layout benchmark"))
+        startLUTLayoutBenchmark();
+    for (const LUTLayoutBenchmarkRow& r : lutLayoutBenchmark.rows)
+        ImGui::Text("%s: GPU %.3f ms, frame %.2f ms", lutLayoutLabels[int(r.layout)], r.gpuMs, r.frameMs);
+    if (ImGui::Button(hairPrimitiveBenchmark.running ? "Hair primitive benchmark running..." : "Run hair primitive benchmark"))
+        startHairPrimitiveBenchmark(availableHairPrimitives(ribbons, rasterizer));
+    for (const HairPrimitiveBenchmarkRow& r : hairPrimitiveBenchmark.rows)
+        ImGui::Text("%s, %s: GPU %.3f ms, frame %.2f ms", getFilenameFromAbsPath(r.groom).c_str(),
+                    hairPrimitiveLabels[int(r.primitive)], r.gpuMs, r.frameMs);
+    for (const char* groom : hairPrimitiveBenchmark.skipped)
+        ImGui::Text("%s: not loaded, skipped", getFilenameFromAbsPath(groom).c_str());
+    if (ImGui::Button(lutFitPending.valid() ? "Fitting..." : "Measure fit error") && !lutFitPending.valid())
+        requestMarschnerFit();
+    ImGui::Text("Fit vs LUT RMS: NR %.4f, TT %.4f, TRT %.4f (max %.3f, %.3f, %.3f)", lutFitError.rmsNR, lutFitError.rmsTT,
+                lutFitError.rmsTRT, lutFitError.maxNR, lutFitError.maxTT, lutFitError.maxTRT);
+    ImGui::Text("Frame twist: max %.1f deg, mean %.2f deg", hairFrameContinuity.maxAngleDegrees, hairFrameContinuity.meanAngleDegrees);
+    ImGui::Text("Frame continuity check: %s (transport max %.1f / %.1f deg SIMD / scalar, bound %.0f)",
+                frameContinuityCheck.passed() ? "pass" : "FAIL", frameContinuityCheck.native.maxAngleDegrees,
+                frameContinuityCheck.scalar.maxAngleDegrees, kFrameContinuityBoundDegrees);
+
+    ImGui::Text("LUT startup: %.1f ms (%s, %u threads)", lutStartupMs, lutStartupFromCache ? "warm cache" : "cold cache",
+                ThreadPool::global().threadCount());
+    ImGui::Text("Shader startup: %.1f ms (%d binaries loaded in %.2f ms, %.1f ms compile saved, %d rejected)",
+                shaderStartupMs, shaderStats.binaryLoads, shaderStats.binaryLoadMs, shaderStats.savedCompileMs,
+                shaderStats.binaryRejects);
+    bool loadBenchmarkRunning = loadBenchmarkPending.valid();
+    if (loadBenchmarkRunning && loadBenchmarkPending.wait_for(chrono::seconds(0)) == future_status::ready) {
+        loadBenchmark = loadBenchmarkPending.get();
+        loadBenchmarkRunning = false;
+    }
+    ImGui::SliderFloat("Synthetic groom (GB)", &loadBenchmarkGigabytes, 0.25f, 8.0f, "%.2f");
+    if (ImGui::Button(loadBenchmarkRunning ? "Load benchmark running..." : "Run load benchmark") && !loadBenchmarkRunning)
+        loadBenchmarkPending = async(launch::async, runHairLoadBenchmark, loadBenchmarkGigabytes);
+    const HairReadTimings& read = loadBenchmark.read;
+    if (read.points > 0) {
+        ImGui::Text("Read %.2f GB: ifstream %.0f ms (%.2f GB/s), mapped %.0f ms (%.2f GB/s)%s", read.bytes / 1e9,
+                    read.ifstreamMs, HairReadTimings::gbPerSecond(read.bytes, read.ifstreamMs),
+                    read.mappedMs, HairReadTimings::gbPerSecond(read.bytes, read.mappedMs),
+                    read.matched ? "" : ", checksum mismatch");
+    }
+    for (const LoadBenchmarkRow& r : loadBenchmark.rows) {
+        const HairModelTimings& t = r.timings;
+        ImGui::Text("%s: load %.1f -> %.1f ms, %.1f -> %.1f MB, walk %.2f -> %.2f ms (AoS -> SoA)",
+                    getFilenameFromAbsPath(r.groom).c_str(), t.aosLoadMs, t.soaLoadMs, t.aosBytes / (1024.0 * 1024.0),
+                    t.soaBytes / (1024.0 * 1024.0), t.aosWalkMs, t.soaWalkMs);
+    }
+    for (const char* groom : loadBenchmark.skipped)
+        ImGui::Text("%s: not found, skipped", getFilenameFromAbsPath(groom).c_str());
+    bool lutBenchmarkRunning = lutBenchmarkPending.valid();
+    if (lutBenchmarkRunning && lutBenchmarkPending.wait_for(chrono::seconds(0)) == future_status::ready) {
+        lutBenchmark = lutBenchmarkPending.get();
+        lutBenchmarkRunning = false;
+    }
+    if (ImGui::Button(lutBenchmarkRunning ? "LUT benchmark running..." : "Run LUT benchmark") && !lutBenchmarkRunning)
+        lutBenchmarkPending = async(launch::async, runLUTBenchmark, lutParams);
+    const MarschnerBatchReport& batch = lutBenchmark.batch;
+    if (batch.samples > 0) {
+        ImGui::Text("LUT cache %d^2: cold %.1f ms, warm %.2f ms", kLUTSize, lutBenchmark.cache.cold, lutBenchmark.cache.warm);
+        ImGui::Text("LUT kernels (%s): cubic x%.1f, Fresnel x%.1f", batch.kernel, batch.cubicSpeedup(), batch.fresnelSpeedup());
+        ImGui::Text("  %s: max error gamma %.2g rad (bound %.0e), Fresnel %.2g (bound %.0e), mismatches %zu / %zu",
+                    batch.passed() ? "pass" : "FAIL", batch.maxGammaError, kMarschnerBatchGammaTolerance,
+                    batch.maxFresnelError, kMarschnerBatchFresnelTolerance, batch.rootMismatches + batch.fresnelMismatches,
+                    batch.samples);
+    }
+    for (const LUTBenchmarkRow& row : lutBenchmark.rows) {
+        // 같은 크기의 1-thread 결과 대비 속도
+        double serialMs = row.timings.total();
+        for (const LUTBenchmarkRow& r : lutBenchmark.rows)
+            if (r.size == row.size && r.threads == 1) serialMs = r.timings.total();
+        ImGui::Text("LUT %4d^2, %2u threads: %8.1f ms (x%.2f)", row.size, row.threads, row.timings.total(),
+                    serialMs / std::max(row.timings.total(), 1e-6));
+    }
+    const HairFrameBenchmark& frames = lutBenchmark.frames;
+    if (frames.vertices > 0) {
+        ImGui::Text("Frames, %zu vertices: calculateUVWdirection %.1f Mverts/s, SIMD %s scalar", frames.vertices,
+                    frames.legacyVerticesPerSecond() / 1e6, frames.identical ? "==" : "!=");
+    }
+    for (const HairFrameBenchmarkRow& row : frames.rows) {
+        ImGui::Text("  %s, %-6s x %2u threads: %7.2f ms, %6.1f Mverts/s/core",
+                    row.mode == HairFrameMode::ParallelTransport ? "transport" : "axis", row.stats.kernel,
+                    row.stats.threads, row.stats.milliseconds, row.stats.verticesPerSecondPerCore(frames.vertices) / 1e6);
     }
 
     //ImGui::Text("shadowDepthRange"); ImGui::Image((ImTextureID)(intptr_t)tex_shadowDepthRange, ImVec2(256, 256), ImVec2(0, 1), ImVec2(1, 0));
@@ -1184,10 +1635,10 @@ int main()
     NR_tex = createNR_Texture(256, 1.55f);
     saveNR_Texture(NR_tex, 256, "NR_texture.png");
 
-    NTT_tex = createNTT_Texture(256, 1.55f, absorption);
+    NTT_tex = createNTT_Texture(256, 1.55f);
     saveNTT_Texture(NTT_tex, 256, "NTT_texture.png");
 
-    NTRT_tex = createNTRT_Texture(256, 1.55f, absorption);
+    NTRT_tex = createNTRT_Texture(256, 1.55f);
     saveNTRT_Texture(NTRT_tex, 256, "NTRT_texture.png");
 
     OBJModel headModel = loadOBJ("../hairstyles/woman_head.ply");
@@ -1364,11 +1815,17 @@ int main() {
     glfwSetErrorCallback(glfwErrorCallback);
     glfwWindowHint(GLFW_ALPHA_BITS, 8);
     glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_FALSE);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // compute culling용으로 4.3을 먼저 시도하고, 안 되면 3.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Hair Rendering", nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(windowWidth, windowHeight, "Hair Rendering", nullptr, nullptr);
+    }
 
     if (!window) {
         cerr << "Failed to create GLFW window" << endl;
@@ -1392,21 +1849,53 @@ int main() {
     SetDarkTheme();
     ImGui::GetStyle().ScaleAllSizes(4.5f);
 
-    GLuint Obj_shaderProgram = loadShaders("obj_shader.vert", "obj_shader.frag");
-    GLuint Hair_shaderProgram = loadShaders("hair_shader.vert", "hair_shader.frag", "hair_shader.geom");
-
-    marschnerTex = createMarschnerTexture(256);
-    saveMarschnerTexture(marschnerTex, 256, "marschner_texture.png");
-
-    NR_tex = createNR_Texture(256, 1.55f);
-    saveNR_Texture(NR_tex, 256, "NR_texture.png");
-
-    NTT_tex = createNTT_Texture(256, 1.55f, absorption);
-    saveNTT_Texture(NTT_tex, 256, "NTT_texture.png");
-
-    NTRT_tex = createNTRT_Texture(256, 1.55f, absorption);
-
-    saveNTRT_Texture(NTRT_tex, 256, "NTRT_texture.png");
+    // sampler unit과 UBO binding은 program 상태라 링크할 때 한 번 정한다
+    shaderRegistry.bindUniformBlock("FrameData", kFrameUniformBinding);
+    shaderRegistry.bindSampler("marschnerTexture", 0);
+    shaderRegistry.bindSampler("NR_texture", 1);
+    shaderRegistry.bindSampler("NTT_texture", 2);
+    shaderRegistry.bindSampler("NTRT_texture", 3);
+    shaderRegistry.bindSampler("clusterTexture", 4);
+    shaderRegistry.bindSampler("N_texture", 5);
+    shaderRegistry.bindSampler("rasterColor", 6);
+    shaderRegistry.bindSampler("rasterDepth", 7);
+    shaderRegistry.bindSampler("NL_texture", 9);    // 8은 hair_raster의 sceneDepth
+    auto shaderStart = chrono::steady_clock::now();
+    ShaderHandle objShader = shaderRegistry.load("obj_shader.vert", "obj_shader.frag");
+    ShaderHandle hairShader = shaderRegistry.load("hair_shader.vert", "hair_shader.frag");
+    ShaderHandle hairShaderGS = kInvalidShader;
+    ShaderHandle hairShaderRibbon = kInvalidShader;
+    ShaderHandle hairRasterResolve = kInvalidShader;
+    shaderStartupMs = chrono::duration<double, milli>(chrono::steady_clock::now() - shaderStart).count();
+    const ShaderRegistryStats& shaderStartup = shaderRegistry.stats();
+    cout << "[Shader] " << shaderStartup.programs << " programs in " << shaderStartupMs << " ms ("
+         << shaderStartup.binaryLoads << " from binary cache, " << shaderStartup.compiles << " compiled, "
+         << shaderStartup.savedCompileMs << " ms compile saved)" << endl;
+
+    frameContinuityCheck = checkFrameContinuity();
+    (frameContinuityCheck.passed() ? cout : cerr) << "[Hair] frame continuity "
+        << (frameContinuityCheck.passed() ? "passed" : "FAILED") << ": parallel transport max "
+        << frameContinuityCheck.native.maxAngleDegrees << " deg (SIMD), " << frameContinuityCheck.scalar.maxAngleDegrees
+        << " deg (scalar), bound " << kFrameContinuityBoundDegrees << " deg; axis frames "
+        << frameContinuityCheck.axis.maxAngleDegrees << " deg" << endl;
+
+    // 캐시가 있으면 LUT 계산 없이 읽기만 한다
+    auto lutStart = chrono::steady_clock::now();
+    MarschnerLUTData luts = loadMarschnerLUTsWithCache(kLUTSize, lutParams);
+    uploadMarschnerLUTs(luts);
+    requestMarschnerFit();
+    lutStartupMs = chrono::duration<double, milli>(chrono::steady_clock::now() - lutStart).count();
+    lutStartupFromCache = luts.fromCache;
+    cout << "[LUT] 4 x " << kLUTSize << "^2 in " << lutStartupMs << " ms (" << (luts.fromCache ? "warm" : "cold")
+         << " cache, " << ThreadPool::global().threadCount() << " threads)" << endl;
+
+    // 확인용 PNG는 새로 만들었을 때만 쓴다
+    if (!luts.fromCache) {
+        saveMarschnerTexture(marschnerTex, kLUTSize, "marschner_texture.png");
+        saveNR_Texture(NR_tex, kLUTSize, "NR_texture.png");
+        saveNTT_Texture(NTT_tex, kLUTSize, "NTT_texture.png");
+        saveNTRT_Texture(NTRT_tex, kLUTSize, "NTRT_texture.png");
+    }
     const GLubyte* version = glGetString(GL_VERSION);
     std::cout << "OpenGL Version: " << version << std::endl;
     const GLubyte* glslVersion = glGetString(GL_SHADING_LANGUAGE_VERSION);
@@ -1417,14 +1906,30 @@ int main() {
     vec3 headcenter = computeMeshCenter(headModel.vertices);
     cameraTarget = headcenter;
 
-    HairModel hairModel;
-    setupHairBuffers(hairModel);
+    HairStreamer hairStreamer;
+    HairCuller hairCuller;
+    hairCuller.init("hair_cull.comp");
+    lutCompute.init("marschner_lut.comp");
+    HairRibbons hairRibbons;
+    hairRibbons.init();
+    HairRasterizer hairRasterizer;
+    hairRasterizer.init("hair_raster_setup.comp", "hair_raster_scan.comp", "hair_raster_tiles.comp");
+    auto lastFrameStart = chrono::steady_clock::now();
+    bool loadingLastFrame = false;
     glEnable(GL_DEPTH_TEST); //이게문제 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
     while (!glfwWindowShouldClose(window)) {
+        auto frameStart = chrono::steady_clock::now();
+        frameMs = chrono::duration<double, milli>(frameStart - lastFrameStart).count();
+        lastFrameStart = frameStart;
+        // 로드 중이던 프레임의 시간 (교체가 일어난 프레임 포함)
+        if (loadingLastFrame) loadMaxFrameMs = std::max(loadMaxFrameMs, frameMs);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        hairPassSubmits.clear();
+        shaderRegistry.update();
+        uniformCallStats = UniformCallStats();
 
         mat4 model = glm::mat4(1.0f);
         
@@ -1448,12 +1953,87 @@ int main() {
         float far = 1000.0f;
         mat4 projection = perspective(radians(fov), aspect, near, far);
         mat4 MVP = projection * view * model;
+        // hair 셰이더 (hair_shader.vert, hair_ribbon.vert, hair_raster_setup.comp)는 정점에 model을 곱한 뒤 MVP를 곱한다.
+        // MVP에 model이 이미 들어 있으므로 hair object space -> clip은 MVP * model이다 (head와 맞춰진 기존 배치).
+        // CPU에서 hair 위치를 다루는 곳 (culling)은 이 두 행렬을 쓴다.
+        mat4 hairToWorld = model * model;
+        mat4 hairMVP = MVP * model;
         vec3 updatedLightPos(lightPos[0], lightPos[1], lightPos[2]);
-        //void renderHair(GLuint shaderProgram, const mat4& MVP, const mat4& model, HairModel& hairmodel, const vec3& cameraPos, const vec3& lightPos) {
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        float pixelsPerUnit = framebufferHeight * 0.5f / tan(radians(fov) * 0.5f);
+
+        // head, hair, shadow 셰이더가 같이 읽는 프레임 데이터는 한 번만 올린다
+        FrameUniforms frame;
+        frame.MVP = MVP;
+        frame.model = model;
+        frame.lightMVP = ortho(-60.0f, 60.0f, -60.0f, 60.0f, 0.1f, 300.0f) * lookAt(updatedLightPos, cameraTarget, vec3(0.0f, 1.0f, 0.0f)) * model;
+        frame.lightPos = updatedLightPos;
+        frame.viewPos = cameraPos;
+        frame.viewportSize = vec2(float(framebufferWidth), float(framebufferHeight));
+        frame.pixelsPerUnit = pixelsPerUnit;
+        frameUniformBuffer.update(frame);
+
+        renderOBJ(shaderRegistry.uniforms(objShader), headModel);
+
+        // 업로드가 끝난 프레임부터 새 VAO로 그린다
+        if (hairStreamer.update(size_t(uploadBudgetMB) * 1024 * 1024)) {
+            const HairLoadResult& loaded = hairStreamer.current();
+            hairLoadFromCache = loaded.hair.fromCache;
+            hairLoadMs = loaded.hair.milliseconds;
+            hairFrameContinuity = loaded.continuity;
+            hairCuller.setStrands(hairStreamer.drawList(), hairStreamer.strandSpheres());
+            hairRibbons.setStrands(hairStreamer.drawList());
+            // cameraTarget = computeHairCenter(hairStreamer.model());
+        }
 
-        renderOBJ(Obj_shaderProgram, MVP, model, headModel, cameraPos, updatedLightPos);
+        lutStreamer.update();
+        updateMarschnerFit();
 
-        renderHair(Hair_shaderProgram, MVP, model, hairModel, cameraPos, updatedLightPos);
+        // strand bounding sphere는 hair의 object space 기준이므로 카메라도 그 공간으로 옮긴다
+        // (ribbon과 software raster는 culling 결과를 쓰지 않는다)
+        bool cullHair = gpuCulling && hairCuller.available() &&
+                        (hairPrimitive == HairPrimitive::Lines || hairPrimitive == HairPrimitive::LinesGeometryShader);
+        if (cullHair) {
+            vec3 cameraPosObject = vec3(inverse(hairToWorld) * vec4(cameraPos, 1.0f));
+
+            cullGpuTimer.begin();
+            hairCuller.cull(hairMVP, cameraPosObject, pixelsPerUnit, cullMinPixels, drawnStrandCount(hairStreamer.model()));
+            cullGpuTimer.end();
+        }
+
+        // 기본 line이 아닌 program은 처음 켤 때 만든다
+        if (int(hairPrimitive) >= availableHairPrimitives(hairRibbons, hairRasterizer))
+            hairPrimitive = HairPrimitive::Lines;
+        ShaderHandle hairProgram = hairShader;
+        if (hairPrimitive == HairPrimitive::LinesGeometryShader) {
+            if (hairShaderGS == kInvalidShader)
+                hairShaderGS = shaderRegistry.load("hair_shader.vert", "hair_shader.frag", "hair_shader.geom");
+            hairProgram = hairShaderGS;
+        }
+        else if (hairPrimitive == HairPrimitive::Ribbons) {
+            if (hairShaderRibbon == kInvalidShader)
+                hairShaderRibbon = shaderRegistry.load("hair_ribbon.vert", "hair_shader.frag");
+            hairProgram = hairShaderRibbon;
+        }
+        else if (hairPrimitive == HairPrimitive::Software) {
+            if (hairRasterResolve == kInvalidShader)
+                hairRasterResolve = shaderRegistry.load("hair_raster_resolve.vert", "hair_raster_resolve.frag");
+            hairProgram = hairRasterResolve;
+        }
+
+        hairGpuTimer.begin();
+        if (hairPrimitive == HairPrimitive::Ribbons)
+            renderHairRibbons(shaderRegistry.uniforms(hairProgram), hairStreamer, hairRibbons);
+        else if (hairPrimitive == HairPrimitive::Software)
+            renderHairSoftware(shaderRegistry.program(hairProgram), hairStreamer, hairRibbons, hairRasterizer,
+                               framebufferWidth, framebufferHeight);
+        else
+            renderHair(shaderRegistry.uniforms(hairProgram), hairStreamer, cullHair ? &hairCuller : nullptr);
+        hairGpuTimer.end();
+        updateBandwidthBenchmark(hairStreamer);
+        updateLUTLayoutBenchmark(hairStreamer);
+        updateHairPrimitiveBenchmark(hairStreamer);
         // 이후 다른 렌더링을 위해 상태 복원
         glDepthMask(GL_TRUE);
        
@@ -1461,18 +2041,19 @@ int main() {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        showGUI(hairModel);
+        showGUI(hairStreamer.model(), hairStreamer, hairCuller, hairRibbons, hairRasterizer);
 
-        if (reloadHair) {
-            hairModel = loadHairFile(selectedHairFile);
-            setupHairBuffers(hairModel);
-            // cameraTarget = computeHairCenter(hairModel);
+        // 로드 중에 다시 요청하면 지금 로드가 끝난 뒤에 시작
+        if (reloadHair && !bandwidthBenchmark.running && !hairPrimitiveBenchmark.running && hairStreamer.request(selectedHairFile, hairFrameMode, hairVertexFormat)) {
+            loadMaxFrameMs = 0.0;
             reloadHair = false;
-
         }
+        loadingLastFrame = hairStreamer.busy();
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+        frameCpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count();
+
         glfwSwapBuffers(window);
 
         glfwPollEvents();
@@ -1482,6 +2063,8 @@ int main() {
     glDeleteTextures(1, &NR_tex);
     glDeleteTextures(1, &NTT_tex);
     glDeleteTextures(1, &NTRT_tex);
+    glDeleteTextures(1, &N_tex);
+    glDeleteTextures(1, &NL_tex);
 
     //glDeleteVertexArrays(1,);
 
@@ -1489,10 +2072,20 @@ int main() {
 
     //glDeleteBuffers(1, &EBO);
 
-    glDeleteVertexArrays(1, &hairVAO);
-    glDeleteBuffers(1, &hairVBO);
-    glDeleteProgram(Obj_shaderProgram);
-    glDeleteProgram(Hair_shaderProgram);
+    hairStreamer.release();
+    lutStreamer.release();
+    if (lutFitPending.valid()) lutFitPending.wait();
+    if (lutComputePending.valid()) lutComputePending.wait();
+    lutCompute.release();
+    shaderRegistry.release();
+    frameUniformBuffer.release();
+    if (lutBenchmarkPending.valid()) lutBenchmarkPending.wait();  // thread pool보다 먼저 끝나야 한다
+    if (loadBenchmarkPending.valid()) loadBenchmarkPending.wait();
+    hairGpuTimer.release();
+    cullGpuTimer.release();
+    hairCuller.release();
+    hairRibbons.release();
+    hairRasterizer.release();
 
     glfwTerminate();
 
@@ -2,8 +2,17 @@
 
 layout(location = 0) in vec3 inPosition;
 
-uniform mat4 MVP_light; 
+// 프레임 데이터 (shader_uniforms.h의 FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer 크기 (pixel)
+    float pixelsPerUnit;    // 거리 1에서 길이 1이 차지하는 pixel 수
+};
 
 void main() {
-    gl_Position = MVP_light * vec4(inPosition, 1.0);
+    gl_Position = lightMVP * vec4(inPosition, 1.0);
 }
@@ -0,0 +1,49 @@
+﻿#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+
+// GL_TIME_ELAPSED query를 몇 프레임 돌려 쓰는 GPU 타이머.
+// 몇 프레임 전 결과를 읽으므로 GPU를 기다리지 않는다 (값은 그만큼 늦게 반영됨).
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin() {
+        if (!queries[0]) glGenQueries(kQueries, queries);
+        GLuint query = queries[next];
+        if (pending[next]) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+            lastMs = ns * 1e-6;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % kQueries;
+    }
+
+    double milliseconds() const { return lastMs; }
+
+    void release() {
+        if (queries[0]) glDeleteQueries(kQueries, queries);
+        for (int i = 0; i < kQueries; ++i) {
+            queries[i] = 0;
+            pending[i] = false;
+        }
+    }
+
+private:
+    static const int kQueries = 4;
+    GLuint queries[kQueries] = {};
+    bool pending[kQueries] = {};
+    int next = 0;
+    double lastMs = 0.0;
+};
+
+#endif
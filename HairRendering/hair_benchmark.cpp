@@ -0,0 +1,342 @@
+﻿#include "hair_benchmark.h"
+#include "hair_file.h"
+#include "hair_model.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+using namespace std;
+using namespace glm;
+
+namespace {
+
+const size_t kChunkPoints = size_t(1) << 20;
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// 예전 loadHairFile의 읽기 부분. 헤더 필드를 하나씩 읽고 배열마다 임시 vector로 복사한다.
+struct LegacyHairArrays {
+    vector<uint16_t> segments;
+    vector<vec3> positions;
+    vector<float> thickness;
+    vector<float> transparency;
+    vector<vec3> colors;
+};
+
+bool readLegacyHairArrays(const string& path, LegacyHairArrays& out) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    file.read(magic, 4);
+    if (strncmp(magic, "HAIR", 4) != 0) return false;
+
+    uint32_t numStrands, numPoints, flags;
+    file.read((char*)&numStrands, 4);
+    file.read((char*)&numPoints, 4);
+    file.read((char*)&flags, 4);
+    if (!(flags & HAIR_HAS_POINTS)) return false;
+
+    uint32_t defaultSegments;
+    float defaultThickness, defaultTransparency, defaultColor[3];
+    file.read((char*)&defaultSegments, 4);
+    file.read((char*)&defaultThickness, 4);
+    file.read((char*)&defaultTransparency, 4);
+    file.read((char*)defaultColor, sizeof(float) * 3);
+    file.ignore(88);
+
+    out.segments.assign(numStrands, uint16_t(defaultSegments));
+    if (flags & HAIR_HAS_SEGMENTS)
+        file.read((char*)out.segments.data(), sizeof(uint16_t) * numStrands);
+    out.positions.resize(numPoints);
+    file.read((char*)out.positions.data(), sizeof(float) * 3 * size_t(numPoints));
+    out.thickness.assign(numPoints, defaultThickness);
+    if (flags & HAIR_HAS_THICKNESS)
+        file.read((char*)out.thickness.data(), sizeof(float) * size_t(numPoints));
+    out.transparency.assign(numPoints, defaultTransparency);
+    if (flags & HAIR_HAS_TRANSPARENCY)
+        file.read((char*)out.transparency.data(), sizeof(float) * size_t(numPoints));
+    out.colors.assign(numPoints, vec3(defaultColor[0], defaultColor[1], defaultColor[2]));
+    if (flags & HAIR_HAS_COLOR)
+        file.read((char*)out.colors.data(), sizeof(float) * 3 * size_t(numPoints));
+    return bool(file);
+}
+
+// 예전 HairModel: strand마다 정점 vector를 따로 할당하는 AoS (56 bytes/정점)
+struct HairVertex {
+    vec3 position;
+    vec3 uDirections;
+    vec3 vDirections;
+    vec3 wDirections;
+    float thickness;
+    float transparency;
+};
+
+struct HairStrand {
+    vector<HairVertex> vertices;
+};
+
+struct LegacyHairModel {
+    vector<HairStrand> strands;
+
+    size_t memoryBytes() const {
+        size_t bytes = strands.capacity() * sizeof(HairStrand);
+        for (const HairStrand& strand : strands)
+            bytes += strand.vertices.capacity() * sizeof(HairVertex);
+        return bytes;
+    }
+};
+
+// 예전 그대로 (마지막 정점의 frame은 쓰지 않음)
+void calculateUVWdirection(HairStrand& hairstrand) {
+    size_t n = hairstrand.vertices.size();
+    if (n < 2) return;
+
+    vec3 u(0.0f);
+    for (size_t i = 0; i < n - 1; i++) {
+        if (i == 0) {
+            u = normalize(hairstrand.vertices[i + 1].position - hairstrand.vertices[i].position);
+        } else {
+            u = normalize(hairstrand.vertices[i + 1].position - hairstrand.vertices[i - 1].position);
+        }
+        hairstrand.vertices[i].uDirections = u;
+
+        vec3 v;
+        if (fabs(u.x) > fabs(u.z)) {
+            v = normalize(vec3(-u.y, u.x, 0.0f));
+        } else {
+            v = normalize(vec3(0.0f, -u.z, u.y));
+        }
+        hairstrand.vertices[i].vDirections = v;
+        hairstrand.vertices[i].wDirections = normalize(cross(u, v));
+    }
+}
+
+bool loadLegacyHairFile(const string& path, LegacyHairModel& model) {
+    LegacyHairArrays arrays;
+    if (!readLegacyHairArrays(path, arrays)) return false;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < arrays.segments.size(); ++i) {
+        size_t count = size_t(arrays.segments[i]) + 1;
+        if (offset + count > arrays.positions.size()) break;
+
+        HairStrand strand;
+        for (size_t j = 0; j < count; ++j) {
+            HairVertex v;
+            v.position = arrays.positions[offset];
+            v.thickness = arrays.thickness[offset];
+            v.transparency = arrays.transparency[offset];
+            strand.vertices.push_back(v);
+            ++offset;
+        }
+        calculateUVWdirection(strand);
+        model.strands.push_back(strand);
+    }
+
+    mat4 R = glm::rotate(mat4(1.0f), glm::radians(90.0f), vec3(1, 0, 0));
+    R = glm::rotate(R, glm::radians(90.0f), vec3(0, 1, 0));
+    for (HairStrand& strand : model.strands)
+        for (HairVertex& v : strand.vertices)
+            v.position = vec3(R * vec4(v.position, 1.0f));
+    return true;
+}
+
+// writeSyntheticHairFile과 같은 나선
+vec3 syntheticPoint(uint64_t strand, float t) {
+    vec3 root(float(strand % 1024) * 0.05f, 0.0f, float(strand / 1024 % 1024) * 0.05f);
+    return root + vec3(0.3f * cosf(t * 0.7f), -0.5f * t, 0.3f * sinf(t * 0.7f));
+}
+
+// 두 경로가 같은 순서로 더해야 checksum이 bit 단위로 같다
+inline double pointSum(const float* p, float thickness, float transparency, const float* c) {
+    return double(p[0]) + p[1] + p[2] + thickness + transparency + c[0] + c[1] + c[2];
+}
+
+}
+
+bool writeSyntheticHairFile(const string& path, uint64_t targetBytes, uint16_t segments) {
+    const uint64_t pointsPerStrand = uint64_t(segments) + 1;
+    const uint64_t bytesPerStrand = sizeof(uint16_t) + pointsPerStrand * 8 * sizeof(float);
+    uint64_t numStrands = std::max<uint64_t>(targetBytes / bytesPerStrand, 1);
+    numStrands = std::min<uint64_t>(numStrands, UINT32_MAX / pointsPerStrand);
+    const uint64_t numPoints = numStrands * pointsPerStrand;
+
+    HairFileHeader header = {};
+    memcpy(header.magic, "HAIR", 4);
+    header.numStrands = uint32_t(numStrands);
+    header.numPoints = uint32_t(numPoints);
+    header.flags = HAIR_HAS_SEGMENTS | HAIR_HAS_POINTS | HAIR_HAS_THICKNESS | HAIR_HAS_TRANSPARENCY | HAIR_HAS_COLOR;
+    header.defaultSegments = segments;
+    header.defaultThickness = 1.0f;
+    header.defaultTransparency = 0.0f;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        cerr << "Failed to write synthetic groom: " << path << endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    vector<uint16_t> segmentChunk(kChunkPoints, segments);
+    for (uint64_t s = 0; s < numStrands; s += kChunkPoints)
+        out.write(reinterpret_cast<const char*>(segmentChunk.data()), std::min<uint64_t>(kChunkPoints, numStrands - s) * sizeof(uint16_t));
+
+    // 배열마다 chunk 단위로 채워서 쓴다 (파일 크기만큼 메모리를 잡지 않도록)
+    vector<float> chunk(kChunkPoints * 3);
+    auto writeSection = [&](int components, const auto& value) {
+        for (uint64_t first = 0; first < numPoints; first += kChunkPoints) {
+            size_t count = size_t(std::min<uint64_t>(kChunkPoints, numPoints - first));
+            for (size_t i = 0; i < count; ++i)
+                for (int k = 0; k < components; ++k)
+                    chunk[i * components + k] = value(first + i, k);
+            out.write(reinterpret_cast<const char*>(chunk.data()), count * components * sizeof(float));
+        }
+    };
+
+    // 머리 모양일 필요는 없고, 좌표 범위만 실제 groom 정도로 둔다 (strand마다 나선)
+    writeSection(3, [&](uint64_t point, int k) {
+        return syntheticPoint(point / pointsPerStrand, float(point % pointsPerStrand))[k];
+    });
+    writeSection(1, [&](uint64_t point, int) { return 1.0f - float(point % pointsPerStrand) / float(pointsPerStrand); });
+    writeSection(1, [](uint64_t, int) { return 0.0f; });
+    writeSection(3, [](uint64_t point, int k) { return 0.2f + 0.1f * k + float(point % 7) * 0.01f; });
+
+    if (!out) {
+        cerr << "Failed to write synthetic groom: " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+HairReadTimings timeHairFileRead(const string& path) {
+    HairReadTimings timings;
+
+    auto start = chrono::steady_clock::now();
+    double legacySum = 0.0;
+    {
+        LegacyHairArrays arrays;
+        if (!readLegacyHairArrays(path, arrays)) {
+            cerr << "Cannot read .hair file: " << path << endl;
+            return timings;
+        }
+        for (size_t i = 0; i < arrays.positions.size(); ++i)
+            legacySum += pointSum(&arrays.positions[i].x, arrays.thickness[i], arrays.transparency[i], &arrays.colors[i].x);
+    }
+    timings.ifstreamMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    double mappedSum = 0.0;
+    {
+        HairFileView hair;
+        if (!hair.open(path)) return timings;
+        const HairFileHeader* h = hair.header;
+        for (size_t i = 0; i < hair.numPoints(); ++i) {
+            const float* color = hair.colors ? hair.colors + 3 * i : h->defaultColor;
+            mappedSum += pointSum(hair.points + 3 * i, hair.pointThickness(i), hair.pointTransparency(i), color);
+        }
+        timings.bytes = hair.file.size();
+        timings.points = hair.numPoints();
+    }
+    timings.mappedMs = elapsedMs(start);
+    timings.matched = legacySum == mappedSum;
+    return timings;
+}
+
+HairModelTimings timeHairModels(const string& path) {
+    HairModelTimings timings;
+    volatile float sink = 0.0f;     // walk가 최적화로 사라지지 않도록
+
+    auto start = chrono::steady_clock::now();
+    LegacyHairModel legacy;
+    if (!loadLegacyHairFile(path, legacy)) return timings;
+    timings.aosLoadMs = elapsedMs(start);
+    timings.aosBytes = legacy.memoryBytes();
+    timings.aosAllocations = legacy.strands.size() + 1;
+
+    start = chrono::steady_clock::now();
+    {
+        int offset = 0;
+        vec3 sum(0.0f);
+        for (const HairStrand& strand : legacy.strands) {
+            offset += int(strand.vertices.size());
+            for (const HairVertex& v : strand.vertices) sum += v.position;
+        }
+        sink = sink + sum.x + float(offset);
+    }
+    timings.aosWalkMs = elapsedMs(start);
+    legacy = LegacyHairModel();
+
+    start = chrono::steady_clock::now();
+    HairModel model = loadHairFile(path);
+    timings.soaLoadMs = elapsedMs(start);
+    timings.soaBytes = model.memoryBytes();
+    timings.vertices = model.vertexCount();
+
+    start = chrono::steady_clock::now();
+    {
+        int offset = 0;
+        for (size_t s = 0; s < model.strandCount(); ++s)
+            offset += int(model.strandSize(s));
+        vec3 sum(0.0f);
+        for (const vec3& p : model.positions) sum += p;
+        sink = sink + sum.x + float(offset);
+    }
+    timings.soaWalkMs = elapsedMs(start);
+    return timings;
+}
+
+HairFrameBenchmark benchmarkHairFrames(size_t numStrands, size_t pointsPerStrand) {
+    HairFrameBenchmark result;
+    HairModel model;
+    model.resize(numStrands, numStrands * pointsPerStrand);
+    for (size_t s = 0; s <= numStrands; ++s)
+        model.strandOffsets[s] = uint32_t(s * pointsPerStrand);
+    for (size_t i = 0; i < model.vertexCount(); ++i)
+        model.positions[i] = syntheticPoint(i / pointsPerStrand, float(i % pointsPerStrand));
+    result.vertices = model.vertexCount();
+
+    {
+        LegacyHairModel legacy;
+        legacy.strands.resize(numStrands);
+        for (size_t s = 0; s < numStrands; ++s) {
+            legacy.strands[s].vertices.resize(pointsPerStrand);
+            for (size_t j = 0; j < pointsPerStrand; ++j)
+                legacy.strands[s].vertices[j].position = model.positions[s * pointsPerStrand + j];
+        }
+        auto start = chrono::steady_clock::now();
+        for (HairStrand& strand : legacy.strands)
+            calculateUVWdirection(strand);
+        result.legacyMs = elapsedMs(start);
+    }
+
+    unsigned maxThreads = ThreadPool::global().threadCount();
+    for (HairFrameMode mode : { HairFrameMode::Axis, HairFrameMode::ParallelTransport }) {
+        HairModel reference;
+        for (HairFrameKernel kernel : { HairFrameKernel::Scalar, HairFrameKernel::Native }) {
+            for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+                HairFrameBenchmarkRow row = { mode, kernel, buildHairFrames(model, mode, threads, kernel) };
+                result.rows.push_back(row);
+                if (threads == maxThreads) break;
+            }
+            if (kernel == HairFrameKernel::Scalar) {
+                reference = model;
+            } else {
+                size_t bytes = model.vertexCount() * sizeof(vec3);
+                result.identical = result.identical &&
+                    memcmp(reference.uDirections.data(), model.uDirections.data(), bytes) == 0 &&
+                    memcmp(reference.vDirections.data(), model.vDirections.data(), bytes) == 0 &&
+                    memcmp(reference.wDirections.data(), model.wDirections.data(), bytes) == 0;
+            }
+        }
+    }
+    return result;
+}
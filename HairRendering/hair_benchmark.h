@@ -0,0 +1,61 @@
+﻿#ifndef HAIR_BENCHMARK_H
+#define HAIR_BENCHMARK_H
+
+#include "hair_frames.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// .hair 로더 벤치마크 (GL 없음, worker thread에서 돌린다).
+// 예전 ifstream 로더와 strand마다 vector<HairVertex>를 두는 AoS 모델은 비교용으로 여기에만 남겨 둔다.
+
+// strand마다 segments개 구간인 합성 groom. segments/points/thickness/transparency/color를 모두 쓴다.
+bool writeSyntheticHairFile(const std::string& path, uint64_t targetBytes, uint16_t segments);
+
+// 같은 파일을 두 경로로 읽고 모든 배열을 한 번씩 훑는다 (둘 다 page cache에 올라온 상태).
+struct HairReadTimings {
+    uint64_t bytes = 0;
+    uint64_t points = 0;
+    double ifstreamMs = 0.0;        // 예전 loadHairFile: ifstream::read로 임시 배열에 복사
+    double mappedMs = 0.0;          // HairFileView: 매핑한 배열을 그대로 읽음
+    bool matched = false;           // 두 경로의 checksum이 같음
+
+    static double gbPerSecond(uint64_t bytes, double ms) { return ms > 0.0 ? bytes / (ms * 1e6) : 0.0; }
+};
+
+HairReadTimings timeHairFileRead(const std::string& path);
+
+// 같은 groom을 예전 AoS 경로 (loadLegacyHairFile)와 지금의 SoA 경로 (loadHairFile)로 읽어 비교한다.
+// walk는 매 프레임 CPU가 하는 일의 대용: strand 범위를 훑고 (예전 draw loop) 모든 위치를 한 번 읽는다.
+struct HairModelTimings {
+    size_t vertices = 0;
+    double aosLoadMs = 0.0;         // ifstream + strand별 push_back + calculateUVWdirection (1 thread)
+    double soaLoadMs = 0.0;         // loadHairFile (mmap, frame builder는 thread pool)
+    size_t aosBytes = 0;            // vector capacity 합 (heap 할당 헤더 제외)
+    size_t soaBytes = 0;
+    size_t aosAllocations = 0;      // strand마다 하나 + strand 배열
+    double aosWalkMs = 0.0;
+    double soaWalkMs = 0.0;
+};
+
+HairModelTimings timeHairModels(const std::string& path);
+
+// frame builder microbenchmark. 합성 groom (strand마다 나선)에서 예전 calculateUVWdirection (1 thread)과
+// buildHairFrames를 커널, frame 방식, 스레드 수별로 잰다.
+struct HairFrameBenchmarkRow {
+    HairFrameMode mode;
+    HairFrameKernel kernel;
+    HairFrameStats stats;
+};
+struct HairFrameBenchmark {
+    size_t vertices = 0;
+    double legacyMs = 0.0;
+    std::vector<HairFrameBenchmarkRow> rows;
+    bool identical = true;          // scalar와 SIMD 커널 결과가 bit 단위로 같음
+
+    double legacyVerticesPerSecond() const { return legacyMs > 0.0 ? vertices / (legacyMs * 1e-3) : 0.0; }
+};
+
+HairFrameBenchmark benchmarkHairFrames(size_t numStrands, size_t pointsPerStrand);
+
+#endif
@@ -0,0 +1,160 @@
+﻿#define GLEW_STATIC
+#include "hair_buffers.h"
+#include "hair_model.h"
+#include <algorithm>
+
+namespace {
+
+HairGpuMemory gpuMemory;
+
+void trackAllocation(size_t oldBytes, size_t newBytes) {
+    gpuMemory.bytes = gpuMemory.bytes - oldBytes + newBytes;
+    if (newBytes != oldBytes) ++gpuMemory.allocations;
+}
+
+size_t grownCapacity(size_t capacity, size_t bytes) {
+    if (bytes > capacity) return std::max(bytes, capacity + capacity / 2);
+    if (bytes < capacity / 4) return bytes;
+    return capacity;
+}
+
+}
+
+const HairGpuMemory& hairGpuMemory() {
+    return gpuMemory;
+}
+
+void HairVertexBuffer::create() {
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    gpuMemory.bufferObjects += 1;
+    setupLayout(HairVertexFormat::Full);
+}
+
+// attribute는 VBO 이름에 묶이므로 storage를 다시 잡아도 그대로 유효하다
+void HairVertexBuffer::setupLayout(HairVertexFormat format) {
+    format_ = format;
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+    GLsizei stride = GLsizei(hairVertexStride(format));
+    for (GLuint i = 0; i <= 8; ++i)
+        glDisableVertexAttribArray(i);
+
+    if (format == HairVertexFormat::Full) {
+        // kHairFloatsPerVertex floats per vertex (packHairVertices / .hairpack)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(0));
+        glEnableVertexAttribArray(0); // position
+
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1); // u
+
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2); // v
+
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(9 * sizeof(float)));
+        glEnableVertexAttribArray(3); // w
+
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(12 * sizeof(float)));
+        glEnableVertexAttribArray(4); // thickness
+
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(13 * sizeof(float)));
+        glEnableVertexAttribArray(5); // transparency
+    } else {
+        // HairCompactVertex. 정수 attribute로 넘기고 셰이더에서 정규화한다 (CPU 복원과 같은 식)
+        glVertexAttribIPointer(6, 4, GL_SHORT, stride, (void*)(0));
+        glEnableVertexAttribArray(6); // position xyz, frame angle
+
+        glVertexAttribIPointer(7, 2, GL_SHORT, stride, (void*)(8));
+        glEnableVertexAttribArray(7); // octahedral u
+
+        glVertexAttribIPointer(8, 2, GL_UNSIGNED_SHORT, stride, (void*)(12));
+        glEnableVertexAttribArray(8); // thickness, transparency
+    }
+
+    glBindVertexArray(0);
+}
+
+void HairVertexBuffer::reserve(size_t bytes, HairVertexFormat format) {
+    if (!vao_) create();
+    if (format != format_) setupLayout(format);
+
+    size_t capacity = grownCapacity(capacity_, bytes);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    trackAllocation(capacity_, capacity);
+    capacity_ = capacity;
+    size_ = bytes;
+}
+
+void HairVertexBuffer::uploadClusters(const std::vector<glm::vec4>& clusters) {
+    if (!clusterBuffer_) {
+        glGenBuffers(1, &clusterBuffer_);
+        glGenTextures(1, &clusterTexture_);
+        gpuMemory.bufferObjects += 1;
+    }
+
+    size_t bytes = clusters.size() * sizeof(glm::vec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, clusterBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, clusters.data(), GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, clusterTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, clusterBuffer_);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    trackAllocation(clusterBytes_, bytes);
+    clusterBytes_ = bytes;
+}
+
+void HairVertexBuffer::destroy() {
+    if (clusterBuffer_) {
+        glDeleteTextures(1, &clusterTexture_);
+        glDeleteBuffers(1, &clusterBuffer_);
+        gpuMemory.bufferObjects -= 1;
+        gpuMemory.bytes -= clusterBytes_;
+    }
+    clusterBuffer_ = clusterTexture_ = 0;
+    clusterBytes_ = 0;
+
+    if (vao_) {
+        glDeleteVertexArrays(1, &vao_);
+        glDeleteBuffers(1, &vbo_);
+        gpuMemory.bufferObjects -= 1;
+        gpuMemory.bytes -= capacity_;
+    }
+    vao_ = vbo_ = 0;
+    size_ = capacity_ = 0;
+    format_ = HairVertexFormat::Full;
+}
+
+void HairStagingBuffer::copy(const void* data, size_t bytes, GLuint dst, size_t dstOffset) {
+    if (!buffer_) {
+        glGenBuffers(1, &buffer_);
+        gpuMemory.bufferObjects += 1;
+    }
+
+    // 매번 orphan하므로 직전 프레임의 복사가 끝나기를 기다리지 않는다
+    size_t capacity = std::max(capacity_, bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_);
+    glBufferData(GL_COPY_READ_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_READ_BUFFER, 0, bytes, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, dstOffset, bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    trackAllocation(capacity_, capacity);
+    capacity_ = capacity;
+}
+
+void HairStagingBuffer::destroy() {
+    if (buffer_) {
+        glDeleteBuffers(1, &buffer_);
+        gpuMemory.bufferObjects -= 1;
+        gpuMemory.bytes -= capacity_;
+    }
+    buffer_ = 0;
+    capacity_ = 0;
+}
@@ -0,0 +1,74 @@
+﻿#ifndef HAIR_BUFFERS_H
+#define HAIR_BUFFERS_H
+
+#include <GL/glew.h>
+#include "hair_compact.h"
+#include <cstddef>
+#include <vector>
+
+// VAO 하나와 VBO 하나를 계속 재사용하는 hair 정점 버퍼.
+// reload 때마다 glGen*을 부르지 않고, storage만 키우거나 orphan한다.
+// Compact 형식이면 cluster origin/scale을 담은 buffer texture도 함께 가진다.
+class HairVertexBuffer {
+public:
+    HairVertexBuffer() = default;
+    HairVertexBuffer(const HairVertexBuffer&) = delete;
+    HairVertexBuffer& operator=(const HairVertexBuffer&) = delete;
+
+    // bytes 크기의 데이터를 받을 storage를 준비한다 (내용은 정의되지 않음).
+    // 용량이 모자라면 1.5배씩 키우고, 충분하면 같은 크기로 orphan해서 GPU가 쓰던 storage를 기다리지 않는다.
+    // 필요량이 용량의 1/4 아래로 떨어지면 줄인다.
+    void reserve(size_t bytes, HairVertexFormat format = HairVertexFormat::Full);
+    void uploadClusters(const std::vector<glm::vec4>& clusters);
+    void destroy();
+
+    GLuint vao() const { return vao_; }
+    GLuint vbo() const { return vbo_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    HairVertexFormat format() const { return format_; }
+    GLuint clusterTexture() const { return clusterTexture_; }
+
+private:
+    void create();
+    void setupLayout(HairVertexFormat format);
+
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    HairVertexFormat format_ = HairVertexFormat::Full;
+
+    GLuint clusterBuffer_ = 0;
+    GLuint clusterTexture_ = 0;
+    size_t clusterBytes_ = 0;
+};
+
+// 업로드용 staging buffer. 같은 방식으로 재사용한다.
+class HairStagingBuffer {
+public:
+    HairStagingBuffer() = default;
+    HairStagingBuffer(const HairStagingBuffer&) = delete;
+    HairStagingBuffer& operator=(const HairStagingBuffer&) = delete;
+
+    // data를 staging에 쓰고 dst의 dstOffset 위치로 GPU에서 복사한다
+    void copy(const void* data, size_t bytes, GLuint dst, size_t dstOffset);
+    void destroy();
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    GLuint buffer_ = 0;
+    size_t capacity_ = 0;
+};
+
+// hair 버퍼가 현재 잡고 있는 GPU 메모리 (reload soak test용)
+struct HairGpuMemory {
+    size_t bytes = 0;
+    size_t bufferObjects = 0;   // 정점 VBO + cluster + staging
+    size_t allocations = 0;     // 지금까지 storage를 새로 잡은 횟수 (orphan 제외)
+};
+
+const HairGpuMemory& hairGpuMemory();
+
+#endif
@@ -0,0 +1,138 @@
+﻿#include "hair_compact.h"
+#include "hair_model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+using namespace glm;
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+
+int16_t toSnorm16(float x) {
+    return int16_t(lroundf(glm::clamp(x, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint16_t toUnorm16(float x) {
+    return uint16_t(lroundf(glm::clamp(x, 0.0f, 1.0f) * 65535.0f));
+}
+
+float fromSnorm16(int16_t x) {
+    return std::max(float(x) / 32767.0f, -1.0f);
+}
+
+float signNotZero(float x) {
+    return x >= 0.0f ? 1.0f : -1.0f;
+}
+
+vec2 octEncode(vec3 n) {
+    n /= fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    vec2 p(n.x, n.y);
+    if (n.z < 0.0f)
+        p = vec2((1.0f - fabsf(n.y)) * signNotZero(n.x), (1.0f - fabsf(n.x)) * signNotZero(n.y));
+    return p;
+}
+
+vec3 octDecode(vec2 p) {
+    vec3 n(p.x, p.y, 1.0f - fabsf(p.x) - fabsf(p.y));
+    if (n.z < 0.0f) {
+        float x = n.x;
+        n.x = (1.0f - fabsf(n.y)) * signNotZero(x);
+        n.y = (1.0f - fabsf(x)) * signNotZero(n.y);
+    }
+    return normalize(n);
+}
+
+// frameFromDelta의 Axis 규칙과 같은 기준 축. Axis 모드 frame은 각도 0으로 저장된다.
+void referenceFrame(const vec3& u, vec3& v0, vec3& w0) {
+    vec3 t = fabsf(u.x) > fabsf(u.z) ? vec3(-u.y, u.x, 0.0f) : vec3(0.0f, -u.z, u.y);
+    v0 = normalize(t);
+    w0 = normalize(cross(u, v0));
+}
+
+vec3 decodeTangent(const HairCompactVertex& c) {
+    return octDecode(vec2(fromSnorm16(c.tangent[0]), fromSnorm16(c.tangent[1])));
+}
+
+}
+
+size_t hairVertexStride(HairVertexFormat format) {
+    return format == HairVertexFormat::Compact ? sizeof(HairCompactVertex) : kHairFloatsPerVertex * sizeof(float);
+}
+
+void packCompactHairVertices(const float* vertices, size_t numVertices, HairCompactData& out) {
+    const size_t clusterSize = size_t(1) << kHairClusterShift;
+    size_t numClusters = (numVertices + clusterSize - 1) / clusterSize;
+    out.vertices.resize(numVertices);
+    out.clusters.resize(numClusters);
+
+    float maxThickness = 0.0f;
+    for (size_t i = 0; i < numVertices; ++i)
+        maxThickness = std::max(maxThickness, vertices[i * kHairFloatsPerVertex + 12]);
+    out.thicknessScale = maxThickness > 0.0f ? maxThickness : 1.0f;
+
+    for (size_t c = 0; c < numClusters; ++c) {
+        size_t begin = c * clusterSize;
+        size_t end = std::min(begin + clusterSize, numVertices);
+
+        vec3 lo(numeric_limits<float>::max());
+        vec3 hi(-numeric_limits<float>::max());
+        for (size_t i = begin; i < end; ++i) {
+            const float* src = vertices + i * kHairFloatsPerVertex;
+            lo = glm::min(lo, vec3(src[0], src[1], src[2]));
+            hi = glm::max(hi, vec3(src[0], src[1], src[2]));
+        }
+        vec3 origin = (lo + hi) * 0.5f;
+        float scale = std::max(std::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5f;
+        if (scale <= 0.0f) scale = 1.0f;
+        out.clusters[c] = vec4(origin, scale);
+
+        for (size_t i = begin; i < end; ++i) {
+            const float* src = vertices + i * kHairFloatsPerVertex;
+            HairCompactVertex& dst = out.vertices[i];
+
+            vec3 p = (vec3(src[0], src[1], src[2]) - origin) / scale;
+            dst.position[0] = toSnorm16(p.x);
+            dst.position[1] = toSnorm16(p.y);
+            dst.position[2] = toSnorm16(p.z);
+
+            vec2 oct = octEncode(vec3(src[3], src[4], src[5]));
+            dst.tangent[0] = toSnorm16(oct.x);
+            dst.tangent[1] = toSnorm16(oct.y);
+
+            // 기준 축은 셰이더와 같게 복원된 u로 만든다
+            vec3 v0, w0;
+            referenceFrame(decodeTangent(dst), v0, w0);
+            vec3 v(src[6], src[7], src[8]);
+            dst.frameAngle = toSnorm16(atan2f(dot(v, w0), dot(v, v0)) / kPi);
+
+            dst.thickness = toUnorm16(src[12] / out.thicknessScale);
+            dst.transparency = toUnorm16(src[13]);
+        }
+    }
+}
+
+HairCompactError measureCompactError(const float* vertices, size_t numVertices, const HairCompactData& compact) {
+    HairCompactError error;
+    for (size_t i = 0; i < numVertices; ++i) {
+        const float* src = vertices + i * kHairFloatsPerVertex;
+        const HairCompactVertex& c = compact.vertices[i];
+        const vec4& cluster = compact.clusters[i >> kHairClusterShift];
+
+        vec3 p = vec3(cluster) + vec3(fromSnorm16(c.position[0]), fromSnorm16(c.position[1]), fromSnorm16(c.position[2])) * cluster.w;
+        error.position = std::max(error.position, length(p - vec3(src[0], src[1], src[2])));
+
+        vec3 u = decodeTangent(c);
+        vec3 v0, w0;
+        referenceFrame(u, v0, w0);
+        float angle = fromSnorm16(c.frameAngle) * kPi;
+        vec3 v = cosf(angle) * v0 + sinf(angle) * w0;
+
+        float du = dot(u, vec3(src[3], src[4], src[5]));
+        float dv = dot(v, vec3(src[6], src[7], src[8]));
+        error.tangentDegrees = std::max(error.tangentDegrees, degrees(acosf(glm::clamp(du, -1.0f, 1.0f))));
+        error.frameDegrees = std::max(error.frameDegrees, degrees(acosf(glm::clamp(dv, -1.0f, 1.0f))));
+    }
+    return error;
+}
@@ -0,0 +1,50 @@
+﻿#ifndef HAIR_COMPACT_H
+#define HAIR_COMPACT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+enum class HairVertexFormat {
+    Full,       // float x 14 (56 bytes): position, u, v, w, thickness, transparency
+    Compact     // 16 bytes: HairCompactVertex
+};
+
+// 압축 정점 (16 bytes).
+// position은 정점 256개(cluster)마다의 origin/scale 기준 snorm16,
+// u(tangent)는 octahedral snorm16, v는 u에서 만든 기준 축과의 각도만 저장하고 w = cross(u, v)로 복원한다.
+struct HairCompactVertex {
+    int16_t position[3];
+    int16_t frameAngle;     // 기준 v축에서 v까지의 각도 / PI
+    int16_t tangent[2];     // octahedral u
+    uint16_t thickness;     // thickness / thicknessScale
+    uint16_t transparency;
+};
+
+static_assert(sizeof(HairCompactVertex) == 16, "unexpected compact hair vertex size");
+
+const uint32_t kHairClusterShift = 8;   // cluster = gl_VertexID >> 8
+
+struct HairCompactData {
+    std::vector<HairCompactVertex> vertices;
+    std::vector<glm::vec4> clusters;    // xyz origin, w scale
+    float thicknessScale = 1.0f;
+};
+
+// 최대 복원 오차 (position은 모델 단위, 방향은 도)
+struct HairCompactError {
+    float position = 0.0f;
+    float tangentDegrees = 0.0f;
+    float frameDegrees = 0.0f;
+};
+
+size_t hairVertexStride(HairVertexFormat format);
+
+// kHairFloatsPerVertex 형식의 정점 데이터를 압축한다
+void packCompactHairVertices(const float* vertices, size_t numVertices, HairCompactData& out);
+
+// hair_shader.vert와 같은 방식으로 복원해서 원본과 비교한다
+HairCompactError measureCompactError(const float* vertices, size_t numVertices, const HairCompactData& compact);
+
+#endif
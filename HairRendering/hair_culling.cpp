@@ -0,0 +1,145 @@
+﻿#define GLEW_STATIC
+#include "hair_culling.h"
+#include "shader.h"
+#include <algorithm>
+using namespace std;
+using namespace glm;
+
+namespace {
+
+const GLuint kLocalSize = 64;
+
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+// Gribb-Hartmann: clip space 평면을 MVP의 행으로 표현 (안쪽이 +)
+void extractFrustumPlanes(const mat4& m, vec4 planes[6]) {
+    vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+    for (int i = 0; i < 6; ++i)
+        planes[i] /= length(vec3(planes[i]));
+}
+
+}
+
+bool HairCuller::init(const char* computeShaderPath) {
+    if (!GLEW_VERSION_4_3) {
+        cerr << "[Hair] GL 4.3 is not available, GPU culling disabled" << endl;
+        return false;
+    }
+
+    program = loadComputeShader(computeShaderPath);
+    if (!program) return false;
+
+    strandCountLoc = glGetUniformLocation(program, "strandCount");
+    frustumPlanesLoc = glGetUniformLocation(program, "frustumPlanes");
+    cameraPosLoc = glGetUniformLocation(program, "cameraPos");
+    pixelsPerUnitLoc = glGetUniformLocation(program, "pixelsPerUnit");
+    minPixelsLoc = glGetUniformLocation(program, "minPixels");
+
+    glGenBuffers(1, &sphereBuffer);
+    glGenBuffers(1, &rangeBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(kCounterBuffers, counterBuffers);
+    for (int i = 0; i < kCounterBuffers; ++i) {
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counterBuffers[i]);
+        glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(HairCullStats), nullptr, GL_DYNAMIC_READ);
+    }
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+    return true;
+}
+
+void HairCuller::setStrands(const HairDrawList& drawList, const vector<vec4>& spheres) {
+    if (!available()) return;
+
+    strands = drawList.size();
+    vector<GLuint> ranges(strands * 2);
+    for (size_t s = 0; s < strands; ++s) {
+        ranges[2 * s] = GLuint(drawList.first[s]);
+        ranges[2 * s + 1] = GLuint(drawList.count[s]);
+    }
+
+    // 명령 버퍼는 strand 수가 늘 때만 다시 잡는다
+    if (strands > strandCapacity) {
+        strandCapacity = std::max(strands, strandCapacity + strandCapacity / 2);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, strandCapacity * sizeof(DrawArraysIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, sphereBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, spheres.size() * sizeof(vec4), spheres.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, rangeBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, ranges.size() * sizeof(GLuint), ranges.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void HairCuller::cull(const mat4& MVP, const vec3& cameraPos, float pixelsPerUnit, float minPixels, size_t strandCount) {
+    culledStrands = std::min(strandCount, strands);
+    if (!available() || culledStrands == 0) return;
+
+    // 이 카운터 버퍼를 마지막으로 쓴 건 kCounterBuffers 프레임 전이므로 읽어도 거의 기다리지 않는다
+    GLuint counters = counterBuffers[frame];
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, counters);
+    if (counterPending[frame])
+        glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(HairCullStats), &lastStats);
+    HairCullStats zero;
+    glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(HairCullStats), &zero);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+    counterPending[frame] = true;
+    frame = (frame + 1) % kCounterBuffers;
+
+    vec4 planes[6];
+    extractFrustumPlanes(MVP, planes);
+
+    glUseProgram(program);
+    glUniform1ui(strandCountLoc, GLuint(culledStrands));
+    glUniform4fv(frustumPlanesLoc, 6, &planes[0].x);
+    glUniform3fv(cameraPosLoc, 1, &cameraPos.x);
+    glUniform1f(pixelsPerUnitLoc, pixelsPerUnit);
+    glUniform1f(minPixelsLoc, minPixels);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sphereBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, rangeBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counters);
+
+    glDispatchCompute(GLuint((culledStrands + kLocalSize - 1) / kLocalSize), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void HairCuller::draw() {
+    if (!available() || culledStrands == 0) return;
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glMultiDrawArraysIndirect(GL_LINE_STRIP, nullptr, GLsizei(culledStrands), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void HairCuller::release() {
+    if (program) glDeleteProgram(program);
+    if (sphereBuffer) glDeleteBuffers(1, &sphereBuffer);
+    if (rangeBuffer) glDeleteBuffers(1, &rangeBuffer);
+    if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    if (counterBuffers[0]) glDeleteBuffers(kCounterBuffers, counterBuffers);
+
+    program = sphereBuffer = rangeBuffer = commandBuffer = 0;
+    for (int i = 0; i < kCounterBuffers; ++i) {
+        counterBuffers[i] = 0;
+        counterPending[i] = false;
+    }
+    strandCapacity = strands = culledStrands = 0;
+}
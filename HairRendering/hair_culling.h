@@ -0,0 +1,66 @@
+﻿#ifndef HAIR_CULLING_H
+#define HAIR_CULLING_H
+
+#include <GL/glew.h>
+#include "hair_model.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+struct HairCullStats {
+    uint32_t drawn = 0;
+    uint32_t frustumCulled = 0;
+    uint32_t sizeCulled = 0;
+};
+
+// GPU-driven hair draw (GL 4.3+).
+// hair_cull.comp가 strand bounding sphere를 frustum과 화면 크기로 검사해서 indirect 명령을 채우고,
+// glMultiDrawArraysIndirect 한 번으로 그린다. 버려진 strand는 정점 처리를 하지 않는다.
+class HairCuller {
+public:
+    HairCuller() = default;
+    HairCuller(const HairCuller&) = delete;
+    HairCuller& operator=(const HairCuller&) = delete;
+
+    // compute shader를 쓸 수 없는 context면 false (호출자는 glMultiDrawArrays로 그린다)
+    bool init(const char* computeShaderPath);
+    bool available() const { return program != 0; }
+
+    // 새 hair로 교체될 때 strand 범위와 bounding sphere를 올린다
+    void setStrands(const HairDrawList& drawList, const std::vector<glm::vec4>& spheres);
+
+    // 앞 strandCount개 strand를 검사한다. MVP/cameraPos는 hair의 object space 기준
+    // (MVP는 hair 셰이더가 곱하는 model까지 포함한 변환).
+    void cull(const glm::mat4& MVP, const glm::vec3& cameraPos, float pixelsPerUnit, float minPixels, size_t strandCount);
+
+    // cull() 결과로 그린다 (hair VAO가 바인딩된 상태에서 호출)
+    void draw();
+
+    // 몇 프레임 전 결과 (GPU를 기다리지 않기 위해)
+    const HairCullStats& stats() const { return lastStats; }
+
+    void release();
+
+private:
+    static const int kCounterBuffers = 3;
+
+    GLuint program = 0;
+    GLuint sphereBuffer = 0;
+    GLuint rangeBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint counterBuffers[kCounterBuffers] = {};
+    bool counterPending[kCounterBuffers] = {};
+    int frame = 0;
+
+    size_t strandCapacity = 0;
+    size_t strands = 0;
+    size_t culledStrands = 0;
+    HairCullStats lastStats;
+
+    GLint strandCountLoc = -1;
+    GLint frustumPlanesLoc = -1;
+    GLint cameraPosLoc = -1;
+    GLint pixelsPerUnitLoc = -1;
+    GLint minPixelsLoc = -1;
+};
+
+#endif
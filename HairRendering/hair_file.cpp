@@ -0,0 +1,168 @@
+﻿#include "hair_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <iostream>
+using namespace std;
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+#ifdef _WIN32
+        fileHandle_ = other.fileHandle_;
+        mappingHandle_ = other.mappingHandle_;
+        other.fileHandle_ = nullptr;
+        other.mappingHandle_ = nullptr;
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mappingHandle_) CloseHandle(mappingHandle_);
+    if (fileHandle_) CloseHandle(fileHandle_);
+    data_ = nullptr;
+    size_ = 0;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+}
+#else
+bool MappedFile::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 매핑은 fd를 닫아도 유지됨
+    if (view == MAP_FAILED) return false;
+
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+#endif
+
+bool HairFileView::open(const string& path) {
+    header = nullptr;
+    segments = nullptr;
+    points = thickness = transparency = colors = nullptr;
+
+    if (!file.open(path)) {
+        cerr << "Cannot open .hair file: " << path << endl;
+        return false;
+    }
+    if (file.size() < sizeof(HairFileHeader)) {
+        cerr << "Invalid .hair format (truncated header)" << endl;
+        return false;
+    }
+
+    const HairFileHeader* h = reinterpret_cast<const HairFileHeader*>(file.data());
+    if (strncmp(h->magic, "HAIR", 4) != 0) {
+        cerr << "Invalid .hair format" << endl;
+        return false;
+    }
+    if (!(h->flags & HAIR_HAS_POINTS)) {
+        cerr << "No point data in .hair file" << endl;
+        return false;
+    }
+
+    // 배열 순서: segments, points, thickness, transparency, color
+    size_t offset = sizeof(HairFileHeader);
+    auto take = [&](uint32_t flag, size_t bytes) -> const unsigned char* {
+        if (!(h->flags & flag)) return nullptr;
+        const unsigned char* p = file.data() + offset;
+        offset += bytes;
+        return p;
+    };
+
+    const unsigned char* segPtr = take(HAIR_HAS_SEGMENTS, sizeof(uint16_t) * size_t(h->numStrands));
+    const unsigned char* pointPtr = take(HAIR_HAS_POINTS, sizeof(float) * 3 * size_t(h->numPoints));
+    const unsigned char* thickPtr = take(HAIR_HAS_THICKNESS, sizeof(float) * size_t(h->numPoints));
+    const unsigned char* transPtr = take(HAIR_HAS_TRANSPARENCY, sizeof(float) * size_t(h->numPoints));
+    const unsigned char* colorPtr = take(HAIR_HAS_COLOR, sizeof(float) * 3 * size_t(h->numPoints));
+
+    if (offset > file.size()) {
+        cerr << "Invalid .hair format (file is " << file.size() << " bytes, expected " << offset << ")" << endl;
+        return false;
+    }
+
+    header = h;
+    segments = reinterpret_cast<const uint16_t*>(segPtr);
+    points = reinterpret_cast<const float*>(pointPtr);
+    thickness = reinterpret_cast<const float*>(thickPtr);
+    transparency = reinterpret_cast<const float*>(transPtr);
+    colors = reinterpret_cast<const float*>(colorPtr);
+    return true;
+}
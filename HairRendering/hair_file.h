@@ -0,0 +1,89 @@
+﻿#ifndef HAIR_FILE_H
+#define HAIR_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// .hair 파일 헤더 (128 bytes), http://www.cemyuksel.com/research/hairmodels/
+#pragma pack(push, 1)
+struct HairFileHeader {
+    char magic[4];              // "HAIR"
+    uint32_t numStrands;
+    uint32_t numPoints;
+    uint32_t flags;
+    uint32_t defaultSegments;
+    float defaultThickness;
+    float defaultTransparency;
+    float defaultColor[3];
+    char fileInfo[88];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(HairFileHeader) == 128, ".hair header must be 128 bytes");
+
+enum HairFileFlags : uint32_t {
+    HAIR_HAS_SEGMENTS = 1 << 0,
+    HAIR_HAS_POINTS = 1 << 1,
+    HAIR_HAS_THICKNESS = 1 << 2,
+    HAIR_HAS_TRANSPARENCY = 1 << 3,
+    HAIR_HAS_COLOR = 1 << 4
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+// Zero-copy view of a .hair file.
+// 배열 포인터는 매핑을 직접 가리키므로 HairFileView가 살아있는 동안만 유효하다.
+// 세그먼트 배열 길이가 홀수면 이후 float 배열은 2-byte 정렬이 된다 (x86에서는 문제 없음).
+struct HairFileView {
+    MappedFile file;
+    const HairFileHeader* header = nullptr;
+
+    const uint16_t* segments = nullptr;   // numStrands, nullptr -> defaultSegments
+    const float* points = nullptr;        // numPoints * 3
+    const float* thickness = nullptr;     // numPoints, nullptr -> defaultThickness
+    const float* transparency = nullptr;  // numPoints, nullptr -> defaultTransparency
+    const float* colors = nullptr;        // numPoints * 3, nullptr -> defaultColor
+
+    bool open(const std::string& path);
+
+    uint32_t numStrands() const { return header ? header->numStrands : 0; }
+    uint32_t numPoints() const { return header ? header->numPoints : 0; }
+
+    uint32_t strandSegments(size_t strand) const {
+        return segments ? segments[strand] : header->defaultSegments;
+    }
+    float pointThickness(size_t point) const {
+        return thickness ? thickness[point] : header->defaultThickness;
+    }
+    float pointTransparency(size_t point) const {
+        return transparency ? transparency[point] : header->defaultTransparency;
+    }
+};
+
+#endif
@@ -0,0 +1,452 @@
+﻿#include "hair_frames.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <cmath>
+
+// scalar 경로의 a * b + c가 FMA로 축약되면 SIMD 커널 (mul, add 따로)과 반올림이 달라진다.
+// GCC는 기본이 -ffp-contract=fast, clang과 MSVC (VS2022 전 /fp:precise)도 축약할 수 있으므로 이 파일에서는 끈다.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+#if defined(__AVX2__)
+#define HAIR_FRAMES_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAIR_FRAMES_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(HAIR_FRAMES_AVX2) || defined(HAIR_FRAMES_SSE)
+#define HAIR_FRAMES_SIMD4
+#endif
+
+using namespace std;
+using namespace glm;
+
+namespace {
+
+// SIMD 커널과 같은 연산 순서를 지켜야 결과가 bit 단위로 같아진다.
+// normalize(x) = x * (1 / sqrt(dot(x, x))), dot = (x*x + y*y) + z*z
+inline void frameFromDelta(float dx, float dy, float dz, vec3& u, vec3& v, vec3& w) {
+    float inv = 1.0f / sqrtf(dx * dx + dy * dy + dz * dz);
+    u = vec3(dx * inv, dy * inv, dz * inv);
+
+    vec3 t;
+    if (fabsf(u.x) > fabsf(u.z)) {
+        t = vec3(-u.y, u.x, 0.0f);
+    } else {
+        t = vec3(0.0f, -u.z, u.y);
+    }
+    inv = 1.0f / sqrtf(t.x * t.x + t.y * t.y + t.z * t.z);
+    v = vec3(t.x * inv, t.y * inv, t.z * inv);
+
+    vec3 c(u.y * v.z - u.z * v.y,
+           u.z * v.x - u.x * v.z,
+           u.x * v.y - u.y * v.x);
+    inv = 1.0f / sqrtf(c.x * c.x + c.y * c.y + c.z * c.z);
+    w = vec3(c.x * inv, c.y * inv, c.z * inv);
+}
+
+inline void scalarFrame(HairModel& model, size_t i, size_t prev, size_t next) {
+    const vec3& a = model.positions[prev];
+    const vec3& b = model.positions[next];
+    frameFromDelta(b.x - a.x, b.y - a.y, b.z - a.z,
+                   model.uDirections[i], model.vDirections[i], model.wDirections[i]);
+}
+
+inline void storeLanes(vec3* dst, const float* x, const float* y, const float* z, int lanes) {
+    for (int k = 0; k < lanes; ++k)
+        dst[k] = vec3(x[k], y[k], z[k]);
+}
+
+#if defined(HAIR_FRAMES_AVX2)
+const char* kernelName = "AVX2";
+const size_t kLanes = 8;
+
+struct Lanes {
+    __m256 x, y, z;
+};
+
+inline Lanes loadLanes(const vec3* p) {
+    const __m256i idx = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const float* base = &p->x;
+    return { _mm256_i32gather_ps(base, idx, 4),
+             _mm256_i32gather_ps(base + 1, idx, 4),
+             _mm256_i32gather_ps(base + 2, idx, 4) };
+}
+
+inline __m256 rcpLength(__m256 x, __m256 y, __m256 z) {
+    __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+    return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len2));
+}
+
+// strand 내부 정점 i..i+7 (이웃: i-1, i+1)
+inline void simdFrames(HairModel& model, size_t i) {
+    Lanes a = loadLanes(&model.positions[i - 1]);
+    Lanes b = loadLanes(&model.positions[i + 1]);
+
+    __m256 dx = _mm256_sub_ps(b.x, a.x);
+    __m256 dy = _mm256_sub_ps(b.y, a.y);
+    __m256 dz = _mm256_sub_ps(b.z, a.z);
+    __m256 inv = rcpLength(dx, dy, dz);
+    __m256 ux = _mm256_mul_ps(dx, inv), uy = _mm256_mul_ps(dy, inv), uz = _mm256_mul_ps(dz, inv);
+
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 useXY = _mm256_cmp_ps(_mm256_andnot_ps(signMask, ux), _mm256_andnot_ps(signMask, uz), _CMP_GT_OQ);
+    __m256 tx = _mm256_blendv_ps(zero, _mm256_xor_ps(uy, signMask), useXY);
+    __m256 ty = _mm256_blendv_ps(_mm256_xor_ps(uz, signMask), ux, useXY);
+    __m256 tz = _mm256_blendv_ps(uy, zero, useXY);
+    inv = rcpLength(tx, ty, tz);
+    __m256 vx = _mm256_mul_ps(tx, inv), vy = _mm256_mul_ps(ty, inv), vz = _mm256_mul_ps(tz, inv);
+
+    __m256 cx = _mm256_sub_ps(_mm256_mul_ps(uy, vz), _mm256_mul_ps(uz, vy));
+    __m256 cy = _mm256_sub_ps(_mm256_mul_ps(uz, vx), _mm256_mul_ps(ux, vz));
+    __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ux, vy), _mm256_mul_ps(uy, vx));
+    inv = rcpLength(cx, cy, cz);
+
+    alignas(32) float x[8], y[8], z[8];
+    _mm256_store_ps(x, ux); _mm256_store_ps(y, uy); _mm256_store_ps(z, uz);
+    storeLanes(&model.uDirections[i], x, y, z, 8);
+    _mm256_store_ps(x, vx); _mm256_store_ps(y, vy); _mm256_store_ps(z, vz);
+    storeLanes(&model.vDirections[i], x, y, z, 8);
+    _mm256_store_ps(x, _mm256_mul_ps(cx, inv)); _mm256_store_ps(y, _mm256_mul_ps(cy, inv)); _mm256_store_ps(z, _mm256_mul_ps(cz, inv));
+    storeLanes(&model.wDirections[i], x, y, z, 8);
+}
+#elif defined(HAIR_FRAMES_SSE)
+const char* kernelName = "SSE2";
+const size_t kLanes = 4;
+
+struct Lanes {
+    __m128 x, y, z;
+};
+
+// vec3 4개 (12 floats)를 x/y/z 레인으로 전치
+inline Lanes loadLanes(const vec3* p) {
+    const float* f = &p->x;
+    __m128 a0 = _mm_loadu_ps(f);      // x0 y0 z0 x1
+    __m128 a1 = _mm_loadu_ps(f + 4);  // y1 z1 x2 y2
+    __m128 a2 = _mm_loadu_ps(f + 8);  // z2 x3 y3 z3
+    __m128 t = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+    __m128 s = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+    return { _mm_shuffle_ps(a0, t, _MM_SHUFFLE(2, 0, 3, 0)),
+             _mm_shuffle_ps(s, t, _MM_SHUFFLE(3, 1, 2, 0)),
+             _mm_shuffle_ps(s, a2, _MM_SHUFFLE(3, 0, 3, 1)) };
+}
+
+inline __m128 rcpLength(__m128 x, __m128 y, __m128 z) {
+    __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len2));
+}
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// strand 내부 정점 i..i+3 (이웃: i-1, i+1)
+inline void simdFrames(HairModel& model, size_t i) {
+    Lanes a = loadLanes(&model.positions[i - 1]);
+    Lanes b = loadLanes(&model.positions[i + 1]);
+
+    __m128 dx = _mm_sub_ps(b.x, a.x);
+    __m128 dy = _mm_sub_ps(b.y, a.y);
+    __m128 dz = _mm_sub_ps(b.z, a.z);
+    __m128 inv = rcpLength(dx, dy, dz);
+    __m128 ux = _mm_mul_ps(dx, inv), uy = _mm_mul_ps(dy, inv), uz = _mm_mul_ps(dz, inv);
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 useXY = _mm_cmpgt_ps(_mm_andnot_ps(signMask, ux), _mm_andnot_ps(signMask, uz));
+    __m128 tx = select(useXY, _mm_xor_ps(uy, signMask), zero);
+    __m128 ty = select(useXY, ux, _mm_xor_ps(uz, signMask));
+    __m128 tz = select(useXY, zero, uy);
+    inv = rcpLength(tx, ty, tz);
+    __m128 vx = _mm_mul_ps(tx, inv), vy = _mm_mul_ps(ty, inv), vz = _mm_mul_ps(tz, inv);
+
+    __m128 cx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+    __m128 cy = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+    __m128 cz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+    inv = rcpLength(cx, cy, cz);
+
+    alignas(16) float x[4], y[4], z[4];
+    _mm_store_ps(x, ux); _mm_store_ps(y, uy); _mm_store_ps(z, uz);
+    storeLanes(&model.uDirections[i], x, y, z, 4);
+    _mm_store_ps(x, vx); _mm_store_ps(y, vy); _mm_store_ps(z, vz);
+    storeLanes(&model.vDirections[i], x, y, z, 4);
+    _mm_store_ps(x, _mm_mul_ps(cx, inv)); _mm_store_ps(y, _mm_mul_ps(cy, inv)); _mm_store_ps(z, _mm_mul_ps(cz, inv));
+    storeLanes(&model.wDirections[i], x, y, z, 4);
+}
+#else
+const char* kernelName = "scalar";
+const size_t kLanes = 0;
+#endif
+
+void buildStrandFrames(HairModel& model, size_t strand, bool simd) {
+    size_t begin = model.strandBegin(strand);
+    size_t end = begin + model.strandSize(strand);
+    if (end - begin < 2) return;
+
+    // 시작점과 끝점은 한쪽 차분
+    scalarFrame(model, begin, begin, begin + 1);
+    scalarFrame(model, end - 1, end - 2, end - 1);
+
+    size_t i = begin + 1;
+#if defined(HAIR_FRAMES_AVX2) || defined(HAIR_FRAMES_SSE)
+    // 블록의 마지막 정점 i + kLanes - 1의 다음 이웃(i + kLanes)이 strand 안에 있어야 한다
+    for (; simd && i + kLanes < end; i += kLanes)
+        simdFrames(model, i);
+#endif
+    for (; i < end - 1; ++i)
+        scalarFrame(model, i, i - 1, i + 1);
+}
+
+
+// ---- Parallel transport (rotation-minimizing) frames ----
+// Double reflection method (Wang et al. 2008). strand를 따라 한 번 훑으며 v를 전파한다.
+// scalar와 SSE가 같은 연산 순서를 쓰도록 lane 타입만 바꿔서 같은 코드를 실행한다.
+
+struct ScalarLane {
+    typedef float V;
+    typedef bool M;
+    static V set(float a) { return a; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V sqrt(V a) { return sqrtf(a); }
+    static M gt(V a, V b) { return a > b; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+};
+
+#if defined(HAIR_FRAMES_SIMD4)
+struct SseLane {
+    typedef __m128 V;
+    typedef __m128 M;
+    static V set(float a) { return _mm_set1_ps(a); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+#endif
+
+template<class L>
+struct LaneVec3 {
+    typename L::V x, y, z;
+};
+
+template<class L>
+inline typename L::V laneDot(const LaneVec3<L>& a, const LaneVec3<L>& b) {
+    return L::add(L::add(L::mul(a.x, b.x), L::mul(a.y, b.y)), L::mul(a.z, b.z));
+}
+
+template<class L>
+inline LaneVec3<L> laneSub(const LaneVec3<L>& a, const LaneVec3<L>& b) {
+    return { L::sub(a.x, b.x), L::sub(a.y, b.y), L::sub(a.z, b.z) };
+}
+
+template<class L>
+inline LaneVec3<L> laneScale(const LaneVec3<L>& a, typename L::V s) {
+    return { L::mul(a.x, s), L::mul(a.y, s), L::mul(a.z, s) };
+}
+
+template<class L>
+inline LaneVec3<L> laneNormalize(const LaneVec3<L>& a) {
+    return laneScale(a, L::div(L::set(1.0f), L::sqrt(laneDot(a, a))));
+}
+
+template<class L>
+inline LaneVec3<L> laneCross(const LaneVec3<L>& a, const LaneVec3<L>& b) {
+    return { L::sub(L::mul(a.y, b.z), L::mul(a.z, b.y)),
+             L::sub(L::mul(a.z, b.x), L::mul(a.x, b.z)),
+             L::sub(L::mul(a.x, b.y), L::mul(a.y, b.x)) };
+}
+
+// 정점 k의 frame (x0, t0, r0)을 정점 k+1 (x1, t1)로 옮긴 r1
+template<class L>
+inline LaneVec3<L> transportStep(const LaneVec3<L>& x0, const LaneVec3<L>& x1,
+                                 const LaneVec3<L>& t0, const LaneVec3<L>& t1, const LaneVec3<L>& r0) {
+    typedef typename L::V V;
+    const V zero = L::set(0.0f);
+    const V two = L::set(2.0f);
+
+    // 첫 번째 반사: 구간 x0 -> x1 의 수직 이등분면 (길이 0인 구간은 건너뜀)
+    LaneVec3<L> v1 = laneSub(x1, x0);
+    V c1 = laneDot(v1, v1);
+    V f1 = L::select(L::gt(c1, zero), L::div(two, c1), zero);
+    LaneVec3<L> rL = laneSub(r0, laneScale(v1, L::mul(f1, laneDot(v1, r0))));
+    LaneVec3<L> tL = laneSub(t0, laneScale(v1, L::mul(f1, laneDot(v1, t0))));
+
+    // 두 번째 반사: 반사된 tangent를 t1에 맞춤
+    LaneVec3<L> v2 = laneSub(t1, tL);
+    V c2 = laneDot(v2, v2);
+    V f2 = L::select(L::gt(c2, zero), L::div(two, c2), zero);
+    LaneVec3<L> r1 = laneSub(rL, laneScale(v2, L::mul(f2, laneDot(v2, rL))));
+
+    // 누적 오차 보정: t1에 직교화 후 정규화
+    r1 = laneSub(r1, laneScale(t1, laneDot(r1, t1)));
+    return laneNormalize(r1);
+}
+
+inline LaneVec3<ScalarLane> scalarLoad(const vec3& a) {
+    return { a.x, a.y, a.z };
+}
+
+inline vec3 scalarStore(const LaneVec3<ScalarLane>& a) {
+    return vec3(a.x, a.y, a.z);
+}
+
+// 첫 정점의 frame은 buildStrandFrames 결과를 그대로 쓰고 이후 정점으로 전파한다
+void transportStrand(HairModel& model, size_t strand) {
+    size_t begin = model.strandBegin(strand);
+    size_t n = model.strandSize(strand);
+
+    LaneVec3<ScalarLane> r = scalarLoad(model.vDirections[begin]);
+    for (size_t k = 0; k + 1 < n; ++k) {
+        size_t i = begin + k;
+        LaneVec3<ScalarLane> t1 = scalarLoad(model.uDirections[i + 1]);
+        r = transportStep<ScalarLane>(scalarLoad(model.positions[i]), scalarLoad(model.positions[i + 1]),
+                                      scalarLoad(model.uDirections[i]), t1, r);
+        model.vDirections[i + 1] = scalarStore(r);
+        model.wDirections[i + 1] = scalarStore(laneNormalize(laneCross(t1, r)));
+    }
+}
+
+#if defined(HAIR_FRAMES_SIMD4)
+// strand 4개를 SSE lane 하나씩에 올려서 동시에 전파한다
+void transportStrands4(HairModel& model, size_t firstStrand, size_t count) {
+    size_t begin[4], size[4];
+    size_t maxSize = 0;
+    for (size_t l = 0; l < 4; ++l) {
+        size_t s = firstStrand + std::min(l, count - 1);  // 남는 lane은 마지막 strand를 중복 (저장은 안 함)
+        begin[l] = model.strandBegin(s);
+        size[l] = l < count ? model.strandSize(s) : 0;
+        maxSize = std::max(maxSize, size[l]);
+    }
+
+    auto gather = [&](const vector<vec3>& src, size_t k) {
+        const vec3* p[4];
+        for (size_t l = 0; l < 4; ++l)
+            p[l] = &src[begin[l] + std::min(k, size[l] > 0 ? size[l] - 1 : 0)];
+        LaneVec3<SseLane> out = { _mm_setr_ps(p[0]->x, p[1]->x, p[2]->x, p[3]->x),
+                                  _mm_setr_ps(p[0]->y, p[1]->y, p[2]->y, p[3]->y),
+                                  _mm_setr_ps(p[0]->z, p[1]->z, p[2]->z, p[3]->z) };
+        return out;
+    };
+    auto scatter = [&](vector<vec3>& dst, size_t k, const LaneVec3<SseLane>& a) {
+        alignas(16) float x[4], y[4], z[4];
+        _mm_store_ps(x, a.x); _mm_store_ps(y, a.y); _mm_store_ps(z, a.z);
+        for (size_t l = 0; l < 4; ++l)
+            if (k < size[l]) dst[begin[l] + k] = vec3(x[l], y[l], z[l]);
+    };
+
+    LaneVec3<SseLane> r = gather(model.vDirections, 0);
+    for (size_t k = 0; k + 1 < maxSize; ++k) {
+        LaneVec3<SseLane> t1 = gather(model.uDirections, k + 1);
+        r = transportStep<SseLane>(gather(model.positions, k), gather(model.positions, k + 1),
+                                   gather(model.uDirections, k), t1, r);
+        scatter(model.vDirections, k + 1, r);
+        scatter(model.wDirections, k + 1, laneNormalize(laneCross(t1, r)));
+    }
+}
+#endif
+
+void transportStrandRange(HairModel& model, size_t first, size_t last, bool simd) {
+    size_t s = first;
+#if defined(HAIR_FRAMES_SIMD4)
+    for (; simd && s + 4 <= last; s += 4)
+        transportStrands4(model, s, 4);
+#endif
+    for (; s < last; ++s)
+        transportStrand(model, s);
+}
+
+}
+
+HairFrameStats buildHairFrames(HairModel& model, HairFrameMode mode, unsigned maxThreads, HairFrameKernel kernel) {
+    auto start = chrono::steady_clock::now();
+    ThreadPool& pool = ThreadPool::global();
+    bool simd = kernel == HairFrameKernel::Native;
+
+    HairFrameStats stats;
+    stats.kernel = simd ? kernelName : "scalar";
+    stats.threads = maxThreads > 0 ? std::min(maxThreads, pool.threadCount()) : pool.threadCount();
+
+    // strand 길이가 제각각이라 chunk를 잘게 나눠 부하를 맞춘다
+    pool.parallelFor(model.strandCount(), 256, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; ++s)
+            buildStrandFrames(model, s, simd);
+        if (mode == HairFrameMode::ParallelTransport)
+            transportStrandRange(model, first, last, simd);
+    }, maxThreads);
+
+    stats.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+HairFrameContinuity measureFrameContinuity(const HairModel& model) {
+    HairFrameContinuity result;
+    if (!model.hasVertexData()) return result;
+
+    double sum = 0.0;
+    size_t count = 0;
+
+    for (size_t s = 0; s < model.strandCount(); ++s) {
+        size_t begin = model.strandBegin(s);
+        size_t end = begin + model.strandSize(s);
+        for (size_t i = begin; i + 1 < end; ++i) {
+            float c = glm::clamp(dot(model.vDirections[i], model.vDirections[i + 1]), -1.0f, 1.0f);
+            float angle = degrees(acosf(c));
+            if (!(angle == angle)) {  // 길이 0인 구간의 NaN frame
+                ++result.nanFrames;
+                continue;
+            }
+            result.maxAngleDegrees = std::max(result.maxAngleDegrees, angle);
+            sum += angle;
+            ++count;
+        }
+    }
+    result.meanAngleDegrees = count > 0 ? float(sum / count) : 0.0f;
+    return result;
+}
+
+HairFrameContinuityCheck checkFrameContinuity() {
+    // strand 9개: SSE transport는 4개씩 두 묶음 + 남는 1개는 scalar, 길이도 SIMD 블록에 딱 맞지 않게 섞는다
+    const size_t numStrands = 9;
+    const float turn = glm::radians(30.0f);
+    HairModel curls;
+    curls.strandOffsets.push_back(0);
+    for (size_t s = 0; s < numStrands; ++s) {
+        size_t n = 61 + 3 * s;
+        // 나선 축을 strand마다 기울여 axis 규칙의 |u.x| > |u.z| 경계를 여러 번 지나게 한다
+        vec3 axis = normalize(vec3(0.3f * float(s % 3), -1.0f, 0.2f * float(s % 4)));
+        vec3 side = normalize(cross(axis, vec3(0.0f, 0.0f, 1.0f)));
+        vec3 up = cross(side, axis);
+        for (size_t k = 0; k < n; ++k) {
+            float a = turn * float(k) + float(s);
+            curls.positions.push_back(vec3(float(s), 0.0f, 0.0f) + cosf(a) * side + sinf(a) * up + 0.05f * float(k) * axis);
+        }
+        curls.strandOffsets.push_back(uint32_t(curls.positions.size()));
+    }
+    size_t vertices = curls.positions.size();
+    curls.uDirections.resize(vertices);
+    curls.vDirections.resize(vertices);
+    curls.wDirections.resize(vertices);
+
+    HairFrameContinuityCheck check;
+    buildHairFrames(curls, HairFrameMode::ParallelTransport, 0, HairFrameKernel::Native);
+    check.native = measureFrameContinuity(curls);
+    buildHairFrames(curls, HairFrameMode::ParallelTransport, 0, HairFrameKernel::Scalar);
+    check.scalar = measureFrameContinuity(curls);
+    buildHairFrames(curls, HairFrameMode::Axis, 0, HairFrameKernel::Native);
+    check.axis = measureFrameContinuity(curls);
+    return check;
+}
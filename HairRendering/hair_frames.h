@@ -0,0 +1,56 @@
+﻿#ifndef HAIR_FRAMES_H
+#define HAIR_FRAMES_H
+
+#include "hair_model.h"
+
+struct HairFrameStats {
+    double milliseconds = 0.0;
+    unsigned threads = 1;
+    const char* kernel = "scalar";
+
+    double verticesPerSecondPerCore(size_t vertices) const {
+        return milliseconds > 0.0 ? vertices / (milliseconds * 1e-3) / threads : 0.0;
+    }
+};
+
+enum class HairFrameKernel {
+    Native,     // 빌드 대상의 SIMD 커널 (AVX2/SSE2), 없으면 scalar
+    Scalar      // 비교와 벤치마크용
+};
+
+// 모든 정점(양 끝점 포함)의 u/v/w frame을 계산한다.
+// strand 단위로 thread pool에 나누고, strand 내부 정점은 SIMD로 처리한다.
+// 결과는 커널(AVX2/SSE/scalar)과 스레드 수에 관계없이 bit 단위로 같다
+// (hair_frames.cpp는 FMA 축약을 끄고 컴파일한다).
+// ParallelTransport 모드는 strand 4개씩 SSE lane에 올려 한 번에 전파한다.
+HairFrameStats buildHairFrames(HairModel& model, HairFrameMode mode = HairFrameMode::Axis, unsigned maxThreads = 0,
+                               HairFrameKernel kernel = HairFrameKernel::Native);
+
+// 이웃 정점 사이 v 방향 변화량 (도). frame이 뒤집히는 곳이 있으면 max가 180도 가까이 나온다.
+struct HairFrameContinuity {
+    float maxAngleDegrees = 0.0f;
+    float meanAngleDegrees = 0.0f;
+    size_t nanFrames = 0;           // 길이 0인 구간 등으로 v가 NaN이라 건너뛴 쌍
+};
+
+HairFrameContinuity measureFrameContinuity(const HairModel& model);
+
+// 합성 곱슬 strand (한 바퀴 12 정점, tangent가 정점마다 약 30도 돎)에서
+// parallel transport frame을 SIMD 커널과 scalar 커널로 만들고, 이웃 v 사이 최대 각을 본다.
+// RMF의 v는 tangent가 도는 만큼만 돌아야 하므로 고정 상한을 넘으면 실패다.
+const float kFrameContinuityBoundDegrees = 45.0f;
+
+struct HairFrameContinuityCheck {
+    HairFrameContinuity native;
+    HairFrameContinuity scalar;
+    HairFrameContinuity axis;       // 참고용: axis frame은 같은 strand에서 뒤집힌다
+
+    bool passed() const {
+        return native.maxAngleDegrees <= kFrameContinuityBoundDegrees && native.nanFrames == 0 &&
+               scalar.maxAngleDegrees <= kFrameContinuityBoundDegrees && scalar.nanFrames == 0;
+    }
+};
+
+HairFrameContinuityCheck checkFrameContinuity();
+
+#endif
@@ -0,0 +1,180 @@
+﻿#define GLM_ENABLE_EXPERIMENTAL
+#include "hair_model.h"
+#include "hair_file.h"
+#include "hair_frames.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+using namespace std;
+using namespace glm;
+
+void HairModel::resize(size_t numStrands, size_t numVertices) {
+    positions.resize(numVertices);
+    uDirections.resize(numVertices);
+    vDirections.resize(numVertices);
+    wDirections.resize(numVertices);
+    thickness.resize(numVertices);
+    transparency.resize(numVertices);
+    strandOffsets.resize(numStrands + 1);
+}
+
+size_t HairModel::memoryBytes() const {
+    return positions.capacity() * sizeof(vec3)
+        + uDirections.capacity() * sizeof(vec3)
+        + vDirections.capacity() * sizeof(vec3)
+        + wDirections.capacity() * sizeof(vec3)
+        + thickness.capacity() * sizeof(float)
+        + transparency.capacity() * sizeof(float)
+        + strandOffsets.capacity() * sizeof(uint32_t);
+}
+
+HairModel loadHairFile(const string& path, HairFrameMode frameMode) {
+    HairModel model;
+    auto loadStart = chrono::steady_clock::now();
+
+    // 파일을 매핑해서 배열을 직접 읽음 (중간 복사 없음)
+    HairFileView hair;
+    if (!hair.open(path))
+        return model;
+
+    uint32_t numStrands = hair.numStrands();
+    uint32_t numPoints = hair.numPoints();
+
+    // Strand offset table
+    vector<uint32_t> offsets(size_t(numStrands) + 1);
+    size_t total = 0;
+    size_t validStrands = numStrands;
+    for (size_t i = 0; i < numStrands; ++i) {
+        offsets[i] = uint32_t(total);
+        size_t count = size_t(hair.strandSegments(i)) + 1;
+        if (total + count > numPoints) {
+            cerr << "Invalid .hair format (strand " << i << " exceeds point count)" << endl;
+            validStrands = i;
+            break;
+        }
+        total += count;
+    }
+    offsets[validStrands] = uint32_t(total);
+    offsets.resize(validStrands + 1);
+
+    model.resize(validStrands, total);
+    model.strandOffsets = std::move(offsets);
+
+    // Rotate model for alignment
+    mat4 R = glm::rotate(mat4(1.0f), glm::radians(90.0f), vec3(1, 0, 0));
+    R = glm::rotate(R, glm::radians(90.0f), vec3(0, 1, 0));
+
+    // frame은 정렬 회전 전의 위치로 계산한다
+    for (size_t i = 0; i < total; ++i) {
+        const float* p = hair.points + 3 * i;
+        model.positions[i] = vec3(p[0], p[1], p[2]);
+        model.thickness[i] = hair.pointThickness(i);
+        model.transparency[i] = hair.pointTransparency(i);
+    }
+    HairFrameStats frames = buildHairFrames(model, frameMode);
+    model.boundsMin = vec3(numeric_limits<float>::max());
+    model.boundsMax = vec3(-numeric_limits<float>::max());
+    for (size_t i = 0; i < total; ++i) {
+        model.positions[i] = vec3(R * vec4(model.positions[i], 1.0f));
+        model.boundsMin = glm::min(model.boundsMin, model.positions[i]);
+        model.boundsMax = glm::max(model.boundsMax, model.positions[i]);
+    }
+
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+    cout << "[Hair] " << path << ": " << validStrands << " strands, " << total
+         << " points loaded in " << loadMs << " ms ("
+         << model.memoryBytes() / (1024.0 * 1024.0) << " MB)" << endl;
+    cout << "[Hair] frames (" << (frameMode == HairFrameMode::ParallelTransport ? "parallel transport" : "axis")
+         << "): " << frames.milliseconds << " ms, " << frames.kernel << " x " << frames.threads
+         << " threads, " << frames.verticesPerSecondPerCore(total) / 1e6 << " Mverts/s/core" << endl;
+
+    return model;
+}
+
+void packHairVertices(const HairModel& model, vector<float>& out) {
+    out.resize(model.vertexCount() * kHairFloatsPerVertex);
+
+    for (size_t i = 0; i < model.vertexCount(); ++i) {
+        float* dst = &out[i * kHairFloatsPerVertex];
+        const vec3& p = model.positions[i];
+        const vec3& u = model.uDirections[i];
+        const vec3& v = model.vDirections[i];
+        const vec3& w = model.wDirections[i];
+
+        dst[0] = p.x;  dst[1] = p.y;  dst[2] = p.z;
+        dst[3] = u.x;  dst[4] = u.y;  dst[5] = u.z;
+        dst[6] = v.x;  dst[7] = v.y;  dst[8] = v.z;
+        dst[9] = w.x;  dst[10] = w.y; dst[11] = w.z;
+        dst[12] = model.thickness[i];
+        dst[13] = model.transparency[i];
+    }
+}
+
+void buildHairDrawList(const HairModel& model, HairDrawList& out) {
+    size_t numStrands = model.strandCount();
+    out.first.resize(numStrands);
+    out.count.resize(numStrands);
+    for (size_t s = 0; s < numStrands; ++s) {
+        out.first[s] = int32_t(model.strandBegin(s));
+        out.count[s] = int32_t(model.strandSize(s));
+    }
+}
+
+void computeStrandSpheres(const float* vertices, const HairModel& model, vector<vec4>& out) {
+    size_t numStrands = model.strandCount();
+    out.resize(numStrands);
+    for (size_t s = 0; s < numStrands; ++s) {
+        uint32_t begin = model.strandBegin(s);
+        uint32_t end = begin + model.strandSize(s);
+
+        vec3 lo(numeric_limits<float>::max());
+        vec3 hi(-numeric_limits<float>::max());
+        for (uint32_t i = begin; i < end; ++i) {
+            const float* p = vertices + size_t(i) * kHairFloatsPerVertex;
+            lo = glm::min(lo, vec3(p[0], p[1], p[2]));
+            hi = glm::max(hi, vec3(p[0], p[1], p[2]));
+        }
+
+        vec3 center = (lo + hi) * 0.5f;
+        float radius2 = 0.0f;
+        for (uint32_t i = begin; i < end; ++i) {
+            const float* p = vertices + size_t(i) * kHairFloatsPerVertex;
+            vec3 d = vec3(p[0], p[1], p[2]) - center;
+            radius2 = std::max(radius2, dot(d, d));
+        }
+        out[s] = end > begin ? vec4(center, sqrtf(radius2)) : vec4(0.0f);
+    }
+}
+
+vec3 computeHairCenter(const HairModel& model) {
+    vec3 sum(0.0f);
+    for (const vec3& p : model.positions) sum += p;
+    return model.positions.empty() ? vec3(0) : sum / float(model.positions.size());
+}
+
+void saveAsOBJ(const string& outPath, const HairModel& model) {
+    ofstream out(outPath);
+    if (!out.is_open()) {
+        cerr << "Failed to write OBJ file." << endl;
+        return;
+    }
+
+    for (const vec3& p : model.positions) {
+        out << "v " << p.x << " " << p.y << " " << p.z << endl;
+    }
+
+    for (size_t s = 0; s < model.strandCount(); ++s) {
+        out << "l";
+        for (uint32_t i = model.strandOffsets[s]; i < model.strandOffsets[s + 1]; ++i) {
+            out << " " << i + 1;
+        }
+        out << endl;
+    }
+
+    out.close();
+}
@@ -0,0 +1,60 @@
+﻿#ifndef HAIR_MODEL_H
+#define HAIR_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+enum class HairFrameMode {
+    Axis,               // u의 x/z 성분 크기로 v 축을 고름 (기존 방식)
+    ParallelTransport   // rotation-minimizing frame, 첫 정점의 frame을 strand를 따라 전파
+};
+
+// Flat structure-of-arrays hair model.
+// 모든 strand의 정점이 하나의 배열에 연속으로 저장되고,
+// strand s의 정점 범위는 [strandOffsets[s], strandOffsets[s + 1]) 이다.
+struct HairModel {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> uDirections;   // tangent
+    std::vector<glm::vec3> vDirections;
+    std::vector<glm::vec3> wDirections;
+    std::vector<float> thickness;
+    std::vector<float> transparency;
+
+    std::vector<uint32_t> strandOffsets;  // numStrands + 1 prefix sum
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    size_t strandCount() const { return strandOffsets.empty() ? 0 : strandOffsets.size() - 1; }
+    size_t vertexCount() const { return strandOffsets.empty() ? 0 : strandOffsets.back(); }
+    bool hasVertexData() const { return !positions.empty(); }
+    uint32_t strandBegin(size_t strand) const { return strandOffsets[strand]; }
+    uint32_t strandSize(size_t strand) const { return strandOffsets[strand + 1] - strandOffsets[strand]; }
+
+    void resize(size_t numStrands, size_t numVertices);
+    size_t memoryBytes() const;
+};
+
+// VBO 정점 형식: position, u, v, w (vec3 x 4), thickness, transparency
+const size_t kHairFloatsPerVertex = 14;
+
+// glMultiDrawArrays용 strand 범위 (GLint first / GLsizei count와 같은 형식)
+struct HairDrawList {
+    std::vector<int32_t> first;
+    std::vector<int32_t> count;
+
+    size_t size() const { return first.size(); }
+};
+
+HairModel loadHairFile(const std::string& path, HairFrameMode frameMode = HairFrameMode::Axis);
+void packHairVertices(const HairModel& model, std::vector<float>& out);
+void buildHairDrawList(const HairModel& model, HairDrawList& out);
+// strand별 bounding sphere (xyz center, w radius). vertices는 kHairFloatsPerVertex 형식
+void computeStrandSpheres(const float* vertices, const HairModel& model, std::vector<glm::vec4>& out);
+glm::vec3 computeHairCenter(const HairModel& model);
+void saveAsOBJ(const std::string& outPath, const HairModel& model);
+
+#endif
@@ -0,0 +1,191 @@
+﻿#include "hair_pack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+using namespace std;
+
+namespace {
+
+const size_t kSectionAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+bool HairPack::open(const string& path) {
+    header_ = nullptr;
+    vertexData_ = nullptr;
+    strandOffsets_ = nullptr;
+
+    if (!file_.open(path)) return false;
+    if (file_.size() < sizeof(HairPackHeader)) return false;
+
+    const HairPackHeader* h = reinterpret_cast<const HairPackHeader*>(file_.data());
+    if (strncmp(h->magic, "HPAK", 4) != 0 || h->version != kHairPackVersion) return false;
+
+    // 잘리거나 깨진 pack은 false를 돌려 .hair에서 다시 만들게 한다.
+    // header 값끼리 곱하거나 더하면 넘칠 수 있으므로 파일 크기로 먼저 자른다.
+    size_t fileSize = file_.size();
+    if (h->floatsPerVertex == 0 || h->numVertices > UINT32_MAX ||
+        h->numVertices > fileSize / (size_t(h->floatsPerVertex) * sizeof(float)) ||
+        h->numStrands >= fileSize / sizeof(uint32_t) ||
+        h->vertexDataOffset > fileSize || h->strandOffsetsOffset > fileSize ||
+        h->strandOffsetsOffset % sizeof(uint32_t) != 0) {
+        cerr << "Invalid hair cache: " << path << endl;
+        return false;
+    }
+    size_t vertexBytes = size_t(h->numVertices) * h->floatsPerVertex * sizeof(float);
+    size_t offsetBytes = size_t(h->numStrands + 1) * sizeof(uint32_t);
+    if (vertexBytes > fileSize - h->vertexDataOffset || offsetBytes > fileSize - h->strandOffsetsOffset) {
+        cerr << "Truncated hair cache: " << path << endl;
+        return false;
+    }
+
+    // strand 정점 범위가 [0, numVertices) 밖으로 나가면 VBO 밖을 읽는다
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(file_.data() + h->strandOffsetsOffset);
+    bool valid = offsets[0] == 0 && offsets[h->numStrands] == h->numVertices;
+    for (uint64_t s = 0; valid && s < h->numStrands; ++s)
+        valid = offsets[s] <= offsets[s + 1];
+    if (!valid) {
+        cerr << "Corrupted strand offsets in hair cache: " << path << endl;
+        return false;
+    }
+
+    header_ = h;
+    vertexData_ = reinterpret_cast<const float*>(file_.data() + h->vertexDataOffset);
+    strandOffsets_ = offsets;
+    return true;
+}
+
+size_t HairPack::vertexDataBytes() const {
+    return header_ ? size_t(header_->numVertices) * header_->floatsPerVertex * sizeof(float) : 0;
+}
+
+// FNV-1a를 8-byte 단위로 적용 (수 GB 파일도 한 번 훑는 정도로 끝나게)
+uint64_t hashBytes(const unsigned char* data, size_t size) {
+    const uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ data[i]) * prime;
+    return hash ^ size;
+}
+
+// wCurly.hair -> wCurly.hairpack, frame 방식별로 따로 둔다 (wCurly_pt.hairpack)
+string hairPackPath(const string& sourcePath, HairFrameMode frameMode) {
+    string base = sourcePath;
+    size_t dot = base.find_last_of('.');
+    size_t slash = base.find_last_of("/\\");
+    if (dot != string::npos && (slash == string::npos || dot > slash))
+        base.resize(dot);
+    if (frameMode == HairFrameMode::ParallelTransport)
+        base += "_pt";
+    return base + ".hairpack";
+}
+
+bool writeHairPack(const string& packPath, uint64_t sourceHash, uint64_t sourceSize, HairFrameMode frameMode,
+                   const HairModel& model, const vector<float>& vertexData, const HairFrameContinuity& continuity) {
+    HairPackHeader header = {};
+    memcpy(header.magic, "HPAK", 4);
+    header.version = kHairPackVersion;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.frameMode = uint32_t(frameMode);
+    header.floatsPerVertex = uint32_t(kHairFloatsPerVertex);
+    header.numStrands = model.strandCount();
+    header.numVertices = model.vertexCount();
+    for (int k = 0; k < 3; ++k) {
+        header.boundsMin[k] = model.boundsMin[k];
+        header.boundsMax[k] = model.boundsMax[k];
+    }
+    header.frameMaxAngleDegrees = continuity.maxAngleDegrees;
+    header.frameMeanAngleDegrees = continuity.meanAngleDegrees;
+    header.frameNanFrames = continuity.nanFrames;
+
+    size_t vertexBytes = vertexData.size() * sizeof(float);
+    header.vertexDataOffset = alignUp(sizeof(HairPackHeader), kSectionAlignment);
+    header.strandOffsetsOffset = alignUp(header.vertexDataOffset + vertexBytes, kSectionAlignment);
+
+    // 쓰는 도중에 실패해도 기존 캐시를 망가뜨리지 않도록 임시 파일에 쓰고 교체
+    string tempPath = packPath + ".tmp";
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        if (!out) {
+            cerr << "Failed to write hair cache: " << tempPath << endl;
+            return false;
+        }
+
+        const char zeros[kSectionAlignment] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(zeros, header.vertexDataOffset - sizeof(header));
+        out.write(reinterpret_cast<const char*>(vertexData.data()), vertexBytes);
+        out.write(zeros, header.strandOffsetsOffset - (header.vertexDataOffset + vertexBytes));
+        out.write(reinterpret_cast<const char*>(model.strandOffsets.data()), model.strandOffsets.size() * sizeof(uint32_t));
+        if (!out) {
+            cerr << "Failed to write hair cache: " << tempPath << endl;
+            return false;
+        }
+    }
+
+    remove(packPath.c_str());
+    if (rename(tempPath.c_str(), packPath.c_str()) != 0) {
+        cerr << "Failed to replace hair cache: " << packPath << endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+LoadedHair loadHairWithCache(const string& sourcePath, HairFrameMode frameMode) {
+    LoadedHair result;
+    auto start = chrono::steady_clock::now();
+
+    MappedFile source;
+    if (!source.open(sourcePath)) {
+        cerr << "Cannot open .hair file: " << sourcePath << endl;
+        return result;
+    }
+    uint64_t sourceHash = hashBytes(source.data(), source.size());
+    uint64_t sourceSize = source.size();
+    source.close();
+
+    string packPath = hairPackPath(sourcePath, frameMode);
+    if (result.pack.open(packPath)) {
+        const HairPackHeader& h = result.pack.header();
+        if (h.sourceHash == sourceHash && h.sourceSize == sourceSize &&
+            h.frameMode == uint32_t(frameMode) && h.floatsPerVertex == kHairFloatsPerVertex) {
+            HairModel& model = result.model;
+            model.strandOffsets.assign(result.pack.strandOffsets(), result.pack.strandOffsets() + h.numStrands + 1);
+            model.boundsMin = glm::vec3(h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]);
+            model.boundsMax = glm::vec3(h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]);
+            result.continuity.maxAngleDegrees = h.frameMaxAngleDegrees;
+            result.continuity.meanAngleDegrees = h.frameMeanAngleDegrees;
+            result.continuity.nanFrames = size_t(h.frameNanFrames);
+            result.fromCache = true;
+        }
+    }
+
+    if (!result.fromCache) {
+        result.pack = HairPack();
+        result.model = loadHairFile(sourcePath, frameMode);
+        packHairVertices(result.model, result.vertexData);
+        result.continuity = measureFrameContinuity(result.model);
+        if (result.model.vertexCount() > 0)
+            writeHairPack(packPath, sourceHash, sourceSize, frameMode, result.model, result.vertexData, result.continuity);
+    }
+
+    result.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "[Hair] " << sourcePath << ": " << (result.fromCache ? "warm (cache hit)" : "cold (cache miss)")
+         << " load in " << result.milliseconds << " ms" << endl;
+    return result;
+}
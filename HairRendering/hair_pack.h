@@ -0,0 +1,81 @@
+﻿#ifndef HAIR_PACK_H
+#define HAIR_PACK_H
+
+#include "hair_file.h"
+#include "hair_model.h"
+#include "hair_frames.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 전처리 결과 캐시 (.hairpack).
+// 원본 .hair 파일의 hash로 구분하고, 정점 데이터는 VBO 형식 그대로 저장해서
+// 매핑한 포인터를 glBufferData에 바로 넘길 수 있다.
+const uint32_t kHairPackVersion = 2;
+
+struct HairPackHeader {
+    char magic[4];                  // "HPAK"
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint32_t frameMode;             // HairFrameMode
+    uint32_t floatsPerVertex;
+    uint64_t numStrands;
+    uint64_t numVertices;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t vertexDataOffset;      // 파일 시작 기준, 64-byte 정렬
+    uint64_t strandOffsetsOffset;   // uint32_t x (numStrands + 1)
+    // 캐시 hit이면 HairModel에 정점 데이터가 없어 다시 잴 수 없으므로 쓸 때 잰 값을 둔다
+    float frameMaxAngleDegrees;     // measureFrameContinuity
+    float frameMeanAngleDegrees;
+    uint64_t frameNanFrames;
+};
+
+static_assert(sizeof(HairPackHeader) == 104, "unexpected .hairpack header padding");
+
+class HairPack {
+public:
+    bool open(const std::string& path);
+
+    const HairPackHeader& header() const { return *header_; }
+    const float* vertexData() const { return vertexData_; }
+    size_t vertexDataBytes() const;
+    const uint32_t* strandOffsets() const { return strandOffsets_; }
+
+private:
+    MappedFile file_;
+    const HairPackHeader* header_ = nullptr;
+    const float* vertexData_ = nullptr;
+    const uint32_t* strandOffsets_ = nullptr;
+};
+
+// 캐시를 거쳐 읽은 hair. GPU에 올릴 정점 데이터는 gpuData()/gpuBytes()로 얻는다.
+struct LoadedHair {
+    HairModel model;                // 캐시 hit이면 strandOffsets와 bounds만 채워짐
+    HairPack pack;                  // 캐시 hit일 때의 매핑
+    std::vector<float> vertexData;  // 캐시 miss일 때 만든 정점 데이터
+    HairFrameContinuity continuity; // 캐시 hit이면 .hairpack에 저장된 값
+    bool fromCache = false;
+    double milliseconds = 0.0;
+
+    const void* gpuData() const { return fromCache ? (const void*)pack.vertexData() : (const void*)vertexData.data(); }
+    size_t gpuBytes() const { return fromCache ? pack.vertexDataBytes() : vertexData.size() * sizeof(float); }
+
+    // GPU 업로드가 끝나면 정점 데이터는 더 필요 없다
+    void releaseGpuData() {
+        pack = HairPack();
+        std::vector<float>().swap(vertexData);
+    }
+};
+
+uint64_t hashBytes(const unsigned char* data, size_t size);
+std::string hairPackPath(const std::string& sourcePath, HairFrameMode frameMode);
+
+bool writeHairPack(const std::string& packPath, uint64_t sourceHash, uint64_t sourceSize, HairFrameMode frameMode,
+                   const HairModel& model, const std::vector<float>& vertexData, const HairFrameContinuity& continuity);
+
+// .hairpack이 원본과 일치하면 그대로 매핑하고, 아니면 .hair를 읽어 전처리한 뒤 캐시를 다시 쓴다.
+LoadedHair loadHairWithCache(const std::string& sourcePath, HairFrameMode frameMode);
+
+#endif
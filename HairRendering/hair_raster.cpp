@@ -0,0 +1,289 @@
+﻿#define GLEW_STATIC
+#include "hair_raster.h"
+#include "shader.h"
+#include <algorithm>
+#include <chrono>
+using namespace std;
+using namespace glm;
+
+namespace {
+
+const int kHairRasterTileSize = 16;     // hair_raster_*.comp의 TILE
+const GLuint kSetupLocalSize = 64;
+const size_t kInitialEntries = size_t(1) << 22;
+const size_t kMaxEntries = size_t(1) << 26;
+const GLuint kColorUnit = 6;            // resolve의 rasterColor, rasterDepth (main의 bindSampler)
+const GLuint kDepthUnit = 7;
+const GLuint kSceneDepthUnit = 8;       // hair_raster_tiles.comp의 sceneDepth
+
+struct RasterCounters {
+    GLuint totalEntries;
+    GLuint overflowEntries;
+};
+
+// 바인딩 번호는 hair_raster_*.comp와 같다
+enum RasterBinding : GLuint {
+    kVertexBinding = 0,
+    kSegmentStartBinding = 1,
+    kScreenSegmentBinding = 2,
+    kTileCountBinding = 3,
+    kTileOffsetBinding = 4,
+    kTileEntryBinding = 5,
+    kStatsBinding = 6,
+};
+
+// measureStages면 앞 단계가 끝날 때까지 기다린 뒤 걸린 시간을 잰다
+class StageClock {
+public:
+    explicit StageClock(bool enabled) : enabled(enabled) {
+        if (enabled) glFinish();
+        last = chrono::steady_clock::now();
+    }
+    double lap() {
+        if (!enabled) return 0.0;
+        glFinish();
+        auto now = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(now - last).count();
+        last = now;
+        return ms;
+    }
+
+private:
+    bool enabled;
+    chrono::steady_clock::time_point last;
+};
+
+// 호출자가 바인딩해 둔 LUT를 건드리지 않도록 resolve unit에서 만든다
+GLuint createTexture(GLuint unit, GLenum format, int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    return texture;
+}
+
+void allocateBuffer(GLuint buffer, size_t bytes) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(bytes, 4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+}
+
+bool HairRasterizer::init(const char* setupShaderPath, const char* scanShaderPath, const char* tileShaderPath) {
+    if (!GLEW_VERSION_4_3) {
+        cerr << "[Hair] GL 4.3 is not available, software rasterizer disabled" << endl;
+        return false;
+    }
+
+    setupProgram = loadComputeShader(setupShaderPath);
+    scanProgram = loadComputeShader(scanShaderPath);
+    tileProgram = loadComputeShader(tileShaderPath);
+    if (!setupProgram || !scanProgram || !tileProgram) {
+        release();
+        return false;
+    }
+
+    setupStageLoc = glGetUniformLocation(setupProgram, "stage");
+    setupSegmentCountLoc = glGetUniformLocation(setupProgram, "segmentCount");
+    setupTilesLoc = glGetUniformLocation(setupProgram, "tiles");
+    setupEntryCapacityLoc = glGetUniformLocation(setupProgram, "entryCapacity");
+    compactVerticesLoc = glGetUniformLocation(setupProgram, "compactVertices");
+    thicknessScaleLoc = glGetUniformLocation(setupProgram, "thicknessScale");
+    widthScaleLoc = glGetUniformLocation(setupProgram, "widthScale");
+    absorptionLoc = glGetUniformLocation(setupProgram, "absorption");
+    scanTileTotalLoc = glGetUniformLocation(scanProgram, "tileTotal");
+    scanEntryCapacityLoc = glGetUniformLocation(scanProgram, "entryCapacity");
+    tileTilesLoc = glGetUniformLocation(tileProgram, "tiles");
+    tileViewportLoc = glGetUniformLocation(tileProgram, "viewport");
+    tileEntryCapacityLoc = glGetUniformLocation(tileProgram, "entryCapacity");
+    glUseProgram(tileProgram);
+    glUniform1i(glGetUniformLocation(tileProgram, "sceneDepth"), kSceneDepthUnit);
+
+    // sampler unit은 hair program과 같게 (main의 bindSampler)
+    glUseProgram(setupProgram);
+    glUniform1i(glGetUniformLocation(setupProgram, "marschnerTexture"), 0);
+    glUniform1i(glGetUniformLocation(setupProgram, "clusterTexture"), 4);
+    glUniform1i(glGetUniformLocation(setupProgram, "N_texture"), 5);
+    glUniform1i(glGetUniformLocation(setupProgram, "NL_texture"), 9);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &screenSegmentBuffer);
+    glGenBuffers(1, &tileCountBuffer);
+    glGenBuffers(1, &tileOffsetBuffer);
+    glGenBuffers(1, &tileEntryBuffer);
+    glGenBuffers(kStatsBuffers, statsBuffers);
+    for (int i = 0; i < kStatsBuffers; ++i)
+        allocateBuffer(statsBuffers[i], sizeof(RasterCounters));
+    entryCapacity = kInitialEntries;
+    allocateBuffer(tileEntryBuffer, entryCapacity * sizeof(GLuint));
+    return true;
+}
+
+void HairRasterizer::resize(int newWidth, int newHeight) {
+    if (newWidth == width && newHeight == height) return;
+    width = newWidth;
+    height = newHeight;
+
+    if (colorTexture) glDeleteTextures(1, &colorTexture);
+    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    if (sceneDepthTexture) glDeleteTextures(1, &sceneDepthTexture);
+    colorTexture = createTexture(kColorUnit, GL_RGBA16F, width, height);
+    depthTexture = createTexture(kDepthUnit, GL_R32F, width, height);
+    sceneDepthTexture = createTexture(kSceneDepthUnit, GL_DEPTH_COMPONENT24, width, height);
+
+    lastStats.tilesX = (width + kHairRasterTileSize - 1) / kHairRasterTileSize;
+    lastStats.tilesY = (height + kHairRasterTileSize - 1) / kHairRasterTileSize;
+    size_t tiles = size_t(lastStats.tilesX) * lastStats.tilesY;
+    allocateBuffer(tileCountBuffer, tiles * sizeof(GLuint));
+    allocateBuffer(tileOffsetBuffer, tiles * sizeof(GLuint));
+}
+
+void HairRasterizer::reserveSegments(size_t segments) {
+    if (segments <= segmentCapacity) return;
+    segmentCapacity = std::max(segments, segmentCapacity + segmentCapacity / 2);
+    allocateBuffer(screenSegmentBuffer, segmentCapacity * 3 * sizeof(vec4));
+}
+
+// 통계 버퍼를 마지막으로 쓴 건 kStatsBuffers 프레임 전이므로 읽어도 거의 기다리지 않는다.
+// 모자랐던 만큼 entry 버퍼를 키운다 (그 사이 프레임은 넘친 segment가 빠진다).
+void HairRasterizer::readStats() {
+    GLuint counters = statsBuffers[frame];
+    if (statsPending[frame]) {
+        RasterCounters read = {};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, counters);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(read), &read);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        lastStats.entries = read.totalEntries;
+        lastStats.overflow = read.overflowEntries;
+        if (read.totalEntries > entryCapacity && entryCapacity < kMaxEntries) {
+            entryCapacity = std::min(kMaxEntries, size_t(read.totalEntries) + read.totalEntries / 4);
+            allocateBuffer(tileEntryBuffer, entryCapacity * sizeof(GLuint));
+        }
+    }
+    statsPending[frame] = true;
+}
+
+void HairRasterizer::draw(const HairRibbons& ribbons, size_t strandCount, const HairRasterParams& params, GLuint resolveProgram) {
+    lastStats.segments = 0;
+    lastTimings = HairRasterTimings();
+    if (!available() || params.width <= 0 || params.height <= 0) return;
+
+    size_t segments = ribbons.segmentCount(strandCount);
+    lastStats.segments = segments;
+    resize(params.width, params.height);
+    reserveSegments(segments);
+    readStats();
+    GLuint counters = statsBuffers[frame];
+    frame = (frame + 1) % kStatsBuffers;
+
+    int tilesX = lastStats.tilesX;
+    int tilesY = lastStats.tilesY;
+    GLuint tileTotal = GLuint(tilesX * tilesY);
+    GLuint setupGroups = GLuint((segments + kSetupLocalSize - 1) / kSetupLocalSize);
+
+    StageClock clock(params.measureStages);
+
+    // 1. 투영 + 셰이딩 + tile별 개수
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVertexBinding, params.vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSegmentStartBinding, ribbons.segments());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kScreenSegmentBinding, screenSegmentBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kTileCountBinding, tileCountBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kTileOffsetBinding, tileOffsetBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kTileEntryBinding, tileEntryBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kStatsBinding, counters);
+
+    glUseProgram(setupProgram);
+    glUniform1i(setupStageLoc, 0);
+    glUniform1ui(setupSegmentCountLoc, GLuint(segments));
+    glUniform2i(setupTilesLoc, tilesX, tilesY);
+    glUniform1ui(setupEntryCapacityLoc, GLuint(entryCapacity));
+    glUniform1i(compactVerticesLoc, params.compactVertices ? 1 : 0);
+    glUniform1f(thicknessScaleLoc, params.thicknessScale);
+    glUniform1f(widthScaleLoc, params.widthScale);
+    glUniform3fv(absorptionLoc, 1, &params.absorption.x);
+    if (setupGroups) glDispatchCompute(setupGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    lastTimings.setupMs = clock.lap();
+
+    // 2. prefix sum (개수는 0으로 되돌린다)
+    glUseProgram(scanProgram);
+    glUniform1ui(scanTileTotalLoc, tileTotal);
+    glUniform1ui(scanEntryCapacityLoc, GLuint(entryCapacity));
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    lastTimings.scanMs = clock.lap();
+
+    // 3. tile별 segment 목록 (개수를 다시 센다)
+    glUseProgram(setupProgram);
+    glUniform1i(setupStageLoc, 1);
+    if (setupGroups) glDispatchCompute(setupGroups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    lastTimings.binMs = clock.lap();
+
+    // 4. tile마다 coverage + OIT. 지금 framebuffer의 depth (head)보다 뒤에 있는 segment는 빠진다.
+    glActiveTexture(GL_TEXTURE0 + kSceneDepthUnit);
+    glBindTexture(GL_TEXTURE_2D, sceneDepthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(tileProgram);
+    glUniform2i(tileTilesLoc, tilesX, tilesY);
+    glUniform2i(tileViewportLoc, width, height);
+    glUniform1ui(tileEntryCapacityLoc, GLuint(entryCapacity));
+    glBindImageTexture(0, colorTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glBindImageTexture(1, depthTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute(GLuint(tilesX), GLuint(tilesY), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    lastTimings.rasterMs = clock.lap();
+
+    // 5. premultiplied 합성. 가려진 segment는 이미 빠졌으므로 가장 앞 hair의 depth를 line 경로처럼 기록만 한다.
+    glUseProgram(resolveProgram);
+    glActiveTexture(GL_TEXTURE0 + kColorUnit); glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glActiveTexture(GL_TEXTURE0 + kDepthUnit); glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glActiveTexture(GL_TEXTURE0);
+    lastTimings.resolveMs = clock.lap();
+}
+
+void HairRasterizer::release() {
+    if (setupProgram) glDeleteProgram(setupProgram);
+    if (scanProgram) glDeleteProgram(scanProgram);
+    if (tileProgram) glDeleteProgram(tileProgram);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (screenSegmentBuffer) glDeleteBuffers(1, &screenSegmentBuffer);
+    if (tileCountBuffer) glDeleteBuffers(1, &tileCountBuffer);
+    if (tileOffsetBuffer) glDeleteBuffers(1, &tileOffsetBuffer);
+    if (tileEntryBuffer) glDeleteBuffers(1, &tileEntryBuffer);
+    if (statsBuffers[0]) glDeleteBuffers(kStatsBuffers, statsBuffers);
+    if (colorTexture) glDeleteTextures(1, &colorTexture);
+    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    if (sceneDepthTexture) glDeleteTextures(1, &sceneDepthTexture);
+
+    setupProgram = scanProgram = tileProgram = vao = 0;
+    screenSegmentBuffer = tileCountBuffer = tileOffsetBuffer = tileEntryBuffer = 0;
+    colorTexture = depthTexture = sceneDepthTexture = 0;
+    for (int i = 0; i < kStatsBuffers; ++i) {
+        statsBuffers[i] = 0;
+        statsPending[i] = false;
+    }
+    width = height = 0;
+    segmentCapacity = entryCapacity = 0;
+    frame = 0;
+    lastStats = HairRasterStats();
+    lastTimings = HairRasterTimings();
+}
@@ -0,0 +1,106 @@
+﻿#ifndef HAIR_RASTER_H
+#define HAIR_RASTER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "hair_ribbons.h"
+
+// 단계별 시간 (ms). GL_TIME_ELAPSED가 0인 software driver (llvmpipe)에서도 재도록 glFinish 사이 wall clock으로 잰다.
+struct HairRasterTimings {
+    double setupMs = 0.0;       // 투영, 셰이딩, tile별 개수
+    double scanMs = 0.0;        // prefix sum
+    double binMs = 0.0;         // tile별 segment 목록
+    double rasterMs = 0.0;      // coverage, 합성
+    double resolveMs = 0.0;     // framebuffer에 그리기
+    double total() const { return setupMs + scanMs + binMs + rasterMs + resolveMs; }
+};
+
+struct HairRasterStats {
+    size_t segments = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    uint32_t entries = 0;       // tile에 들어간 segment 수 (몇 프레임 전)
+    uint32_t overflow = 0;      // 용량이 모자라 버려진 수. 다음 프레임에 버퍼를 키운다.
+};
+
+struct HairRasterParams {
+    GLuint vertexBuffer = 0;    // HairVertexBuffer::vbo()
+    bool compactVertices = false;
+    float thicknessScale = 1.0f;
+    float widthScale = 1.0f;
+    glm::vec3 absorption = glm::vec3(0.0f);
+    int width = 0;              // framebuffer 크기
+    int height = 0;
+    bool measureStages = false; // 단계마다 glFinish (timings())
+};
+
+// sub-pixel 굵기의 hair를 compute shader로 rasterize한다 (GL 4.3+).
+// HairRibbons의 segment 목록을 hair_raster_setup.comp가 화면으로 투영하고 kHairRasterTileSize tile에 나눠 담은 뒤,
+// hair_raster_tiles.comp가 tile마다 strand 폭으로 pixel coverage를 계산해 weighted blended OIT로 합친다.
+// 셰이딩은 segment 중점에서 packed LUT (marschnerTexture, N_texture, NL_texture)로 한 번 한다.
+class HairRasterizer {
+public:
+    HairRasterizer() = default;
+    HairRasterizer(const HairRasterizer&) = delete;
+    HairRasterizer& operator=(const HairRasterizer&) = delete;
+
+    // compute shader를 쓸 수 없는 context면 false (호출자는 line으로 그린다)
+    bool init(const char* setupShaderPath, const char* scanShaderPath, const char* tileShaderPath);
+    bool available() const { return tileProgram != 0; }
+
+    // 앞 strandCount개 strand를 rasterize하고 resolveProgram (hair_raster_resolve.*)으로 framebuffer에 합성한다.
+    // LUT는 unit 0 (marschnerTexture), 5 (N_texture), 9 (NL_texture), cluster는 unit 4에 바인딩된 상태에서 호출한다.
+    // 읽기 framebuffer의 depth (head를 그린 뒤)보다 뒤에 있는 hair는 그리지 않는다.
+    void draw(const HairRibbons& ribbons, size_t strandCount, const HairRasterParams& params, GLuint resolveProgram);
+
+    const HairRasterStats& stats() const { return lastStats; }
+    const HairRasterTimings& timings() const { return lastTimings; }
+
+    void release();
+
+private:
+    void resize(int width, int height);
+    void reserveSegments(size_t segments);
+    void readStats();
+
+    static const int kStatsBuffers = 3;
+
+    GLuint setupProgram = 0;
+    GLuint scanProgram = 0;
+    GLuint tileProgram = 0;
+    GLuint vao = 0;                 // resolve용 빈 VAO
+    GLuint screenSegmentBuffer = 0;
+    GLuint tileCountBuffer = 0;
+    GLuint tileOffsetBuffer = 0;
+    GLuint tileEntryBuffer = 0;
+    GLuint statsBuffers[kStatsBuffers] = {};
+    bool statsPending[kStatsBuffers] = {};
+    int frame = 0;
+    GLuint colorTexture = 0;        // RGBA16F, premultiplied
+    GLuint depthTexture = 0;        // R32F, 가장 앞 hair의 window depth
+    GLuint sceneDepthTexture = 0;   // tile pass 전에 framebuffer depth를 복사해 둔다
+
+    int width = 0;
+    int height = 0;
+    size_t segmentCapacity = 0;
+    size_t entryCapacity = 0;
+
+    HairRasterStats lastStats;
+    HairRasterTimings lastTimings;
+
+    GLint setupStageLoc = -1;
+    GLint setupSegmentCountLoc = -1;
+    GLint setupTilesLoc = -1;
+    GLint setupEntryCapacityLoc = -1;
+    GLint compactVerticesLoc = -1;
+    GLint thicknessScaleLoc = -1;
+    GLint widthScaleLoc = -1;
+    GLint absorptionLoc = -1;
+    GLint scanTileTotalLoc = -1;
+    GLint scanEntryCapacityLoc = -1;
+    GLint tileTilesLoc = -1;
+    GLint tileViewportLoc = -1;
+    GLint tileEntryCapacityLoc = -1;
+};
+
+#endif
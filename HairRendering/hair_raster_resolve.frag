@@ -0,0 +1,16 @@
+#version 330 core
+
+// 소프트웨어 rasterizer 결과를 합성한다. 머리 뒤의 hair는 tile pass에서 이미 빠졌고,
+// 가장 앞 hair의 depth는 line 경로처럼 depth buffer에 남긴다.
+uniform sampler2D rasterColor;  // premultiplied
+uniform sampler2D rasterDepth;
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 color = texelFetch(rasterColor, pixel, 0);
+    if (color.a <= 0.0) discard;
+    gl_FragDepth = texelFetch(rasterDepth, pixel, 0).r;
+    FragColor = color;
+}
@@ -0,0 +1,7 @@
+#version 330 core
+
+// 화면을 덮는 삼각형 하나 (attribute 없음)
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,162 @@
+#version 430 core
+
+// Ribbon 모드 (vertex pulling, GL 4.3+).
+// 정점 attribute 없이 hair VBO를 SSBO로 읽고, segment 하나를 화면을 향한 quad (삼각형 2개, 정점 6개)로 늘린다.
+// glDrawArrays(GL_TRIANGLES, 0, segments * 6) 한 번으로 그린다. 셰이딩 값은 hair_shader.vert와 같은 식.
+
+// HairVertexBuffer의 VBO 그대로 (Full: float 14개, Compact: HairCompactVertex 16 B)
+layout (std430, binding = 0) readonly buffer HairVertices { uint vertexWords[]; };
+// segment마다 시작 정점 index (HairRibbons::setStrands)
+layout (std430, binding = 1) readonly buffer RibbonSegments { uint segmentStart[]; };
+
+out HairVarying {
+    vec3 fragPos;
+    vec3 u;
+    vec3 v;
+    vec3 w;
+    float sinThetaI;
+    float sinThetaO;
+    float cosThetaI;
+    float cosThetaO;
+    float cosPhiD;
+    float thickness;
+    float transparency;
+} hair;
+
+// 프레임 데이터 (shader_uniforms.h의 FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer 크기 (pixel)
+    float pixelsPerUnit;    // 거리 1에서 길이 1이 차지하는 pixel 수
+};
+
+uniform bool compactVertices;
+uniform samplerBuffer clusterTexture;  // 정점 256개마다 xyz origin, w scale
+uniform float thicknessScale;
+uniform float ribbonWidthScale;        // thickness에 곱하는 값
+uniform float ribbonMinPixels;         // 너무 얇아서 사라지지 않게 하는 최소 폭
+
+const float PI = 3.1415926535897932384626433832795;
+const int FULL_FLOATS = 14;            // kHairFloatsPerVertex
+
+// quad 정점 6개: (segment 끝점 0/1, 옆 -1/+1)
+const vec2 CORNERS[6] = vec2[](vec2(0, -1), vec2(1, -1), vec2(1, 1), vec2(0, -1), vec2(1, 1), vec2(0, 1));
+
+struct HairPoint {
+    vec3 position;
+    vec3 u;
+    vec3 v;
+    vec3 w;
+    float thickness;
+    float transparency;
+};
+
+vec2 snorm16(ivec2 x) { return max(vec2(x) / 32767.0, -1.0); }
+
+vec3 octDecode(vec2 p) {
+    vec3 n = vec3(p.x, p.y, 1.0 - abs(p.x) - abs(p.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+float fullFloat(uint index, int offset) { return uintBitsToFloat(vertexWords[index * FULL_FLOATS + offset]); }
+vec3 fullVec3(uint index, int offset) { return vec3(fullFloat(index, offset), fullFloat(index, offset + 1), fullFloat(index, offset + 2)); }
+
+// int16 두 개 (little endian)
+ivec2 shorts(uint word) { return ivec2(bitfieldExtract(int(word), 0, 16), bitfieldExtract(int(word), 16, 16)); }
+uvec2 ushorts(uint word) { return uvec2(word & 0xffffu, word >> 16); }
+
+vec3 compactPosition(uint index, out ivec4 packedPosition) {
+    packedPosition = ivec4(shorts(vertexWords[index * 4u]), shorts(vertexWords[index * 4u + 1u]));
+    vec4 cluster = texelFetch(clusterTexture, int(index >> 8));
+    return cluster.xyz + vec3(snorm16(packedPosition.xy), snorm16(packedPosition.zw).x) * cluster.w;
+}
+
+// 옆 끝점은 위치만 있으면 된다
+vec3 loadPosition(uint index) {
+    ivec4 packedPosition;
+    return compactVertices ? compactPosition(index, packedPosition) : fullVec3(index, 0);
+}
+
+// hair_shader.vert의 unpackVertex와 같은 식 (정점 index를 gl_VertexID 대신 쓴다)
+HairPoint loadPoint(uint index) {
+    HairPoint p;
+    if (!compactVertices) {
+        p.position = fullVec3(index, 0);
+        p.u = fullVec3(index, 3);
+        p.v = fullVec3(index, 6);
+        p.w = fullVec3(index, 9);
+        p.thickness = fullFloat(index, 12);
+        p.transparency = fullFloat(index, 13);
+        return p;
+    }
+
+    ivec4 packedPosition;
+    p.position = compactPosition(index, packedPosition);
+    ivec2 packedTangent = shorts(vertexWords[index * 4u + 2u]);
+    uvec2 packedShade = ushorts(vertexWords[index * 4u + 3u]);
+
+    p.u = octDecode(snorm16(packedTangent));
+    vec3 t = abs(p.u.x) > abs(p.u.z) ? vec3(-p.u.y, p.u.x, 0.0) : vec3(0.0, -p.u.z, p.u.y);
+    vec3 v0 = normalize(t);
+    vec3 w0 = normalize(cross(p.u, v0));
+    float angle = snorm16(packedPosition.zw).y * PI;
+    p.v = cos(angle) * v0 + sin(angle) * w0;
+    p.w = cross(p.u, p.v);
+
+    p.thickness = float(packedShade.x) / 65535.0 * thicknessScale;
+    p.transparency = float(packedShade.y) / 65535.0;
+    return p;
+}
+
+void main() {
+    uint segment = uint(gl_VertexID) / 6u;
+    vec2 corner = CORNERS[gl_VertexID % 6];
+    uint first = segmentStart[segment];
+
+    HairPoint p = loadPoint(first + uint(corner.x));
+    // 두 끝점을 같은 방향으로 늘려야 quad가 접히지 않으므로 다른 끝점 위치도 읽는다
+    vec3 p0 = vec3(model * vec4(corner.x == 0.0 ? p.position : loadPosition(first), 1.0));
+    vec3 p1 = vec3(model * vec4(corner.x == 0.0 ? loadPosition(first + 1u) : p.position, 1.0));
+
+    hair.fragPos = corner.x == 0.0 ? p0 : p1;
+
+    vec3 lightDir = normalize(lightPos - hair.fragPos);
+    vec3 viewDir = normalize(viewPos - hair.fragPos);
+
+    hair.u = normalize(mat3(model) * p.u);
+    hair.v = normalize(mat3(model) * p.v);
+    hair.w = normalize(mat3(model) * p.w);
+
+    hair.sinThetaI = dot(lightDir, hair.u);
+    hair.sinThetaO = dot(viewDir, hair.u);
+    hair.cosThetaI = dot(lightDir, hair.w);
+    hair.cosThetaO = dot(viewDir, hair.w);
+
+    vec3 lightPerp = lightDir - hair.sinThetaI * hair.u;
+    vec3 eyePerp = viewDir - hair.sinThetaO * hair.u;
+    hair.cosPhiD = pow(dot(eyePerp, lightPerp) * dot(eyePerp, eyePerp) * dot(lightPerp, lightPerp), 0.5);
+
+    hair.thickness = p.thickness;
+    hair.transparency = p.transparency;
+
+    // line 경로와 같은 clip 좌표에서 segment에 수직인 화면 방향으로 폭의 절반씩 민다
+    vec4 clip0 = MVP * vec4(p0, 1.0);
+    vec4 clip1 = MVP * vec4(p1, 1.0);
+    vec2 screen0 = clip0.xy / clip0.w * viewportSize;
+    vec2 screen1 = clip1.xy / clip1.w * viewportSize;
+    vec2 direction = screen1 - screen0;
+    direction = dot(direction, direction) > 1e-12 ? normalize(direction) : vec2(1.0, 0.0);
+    vec2 normal = vec2(-direction.y, direction.x);
+
+    vec4 clip = corner.x == 0.0 ? clip0 : clip1;
+    float widthPixels = max(p.thickness * ribbonWidthScale * pixelsPerUnit / max(clip.w, 1e-4), ribbonMinPixels);
+    // NDC 1은 viewport 절반이므로 pixel 폭을 NDC로 바꿀 때 2 / viewportSize
+    clip.xy += normal * corner.y * widthPixels / viewportSize * clip.w;
+    gl_Position = clip;
+}
@@ -0,0 +1,60 @@
+﻿#define GLEW_STATIC
+#include "hair_ribbons.h"
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+bool HairRibbons::init() {
+    if (!GLEW_VERSION_4_3) {
+        cerr << "[Hair] GL 4.3 is not available, ribbon mode disabled" << endl;
+        return false;
+    }
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &segmentBuffer);
+    return true;
+}
+
+void HairRibbons::setStrands(const HairDrawList& drawList) {
+    if (!available()) return;
+
+    // 점이 n개인 strand는 segment n-1개. strand 경계를 넘는 segment는 만들지 않는다.
+    size_t strands = drawList.size();
+    segmentOffsets.assign(strands + 1, 0);
+    for (size_t s = 0; s < strands; ++s)
+        segmentOffsets[s + 1] = segmentOffsets[s] + size_t(std::max(drawList.count[s] - 1, 0));
+
+    vector<GLuint> starts(segmentOffsets[strands]);
+    for (size_t s = 0; s < strands; ++s) {
+        GLuint first = GLuint(drawList.first[s]);
+        for (size_t k = segmentOffsets[s]; k < segmentOffsets[s + 1]; ++k)
+            starts[k] = first++;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, segmentBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, max<size_t>(starts.size(), 1) * sizeof(GLuint), starts.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+size_t HairRibbons::segmentCount(size_t strandCount) const {
+    if (segmentOffsets.empty()) return 0;
+    return segmentOffsets[std::min(strandCount, segmentOffsets.size() - 1)];
+}
+
+void HairRibbons::draw(GLuint vertexBuffer, size_t strandCount) {
+    lastSegments = available() ? segmentCount(strandCount) : 0;
+    if (lastSegments == 0) return;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, segmentBuffer);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, GLsizei(lastSegments * 6));
+    glBindVertexArray(0);
+}
+
+void HairRibbons::release() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (segmentBuffer) glDeleteBuffers(1, &segmentBuffer);
+    vao = segmentBuffer = 0;
+    segmentOffsets.clear();
+    lastSegments = 0;
+}
@@ -0,0 +1,43 @@
+﻿#ifndef HAIR_RIBBONS_H
+#define HAIR_RIBBONS_H
+
+#include <GL/glew.h>
+#include "hair_model.h"
+#include <vector>
+
+// 두꺼운 hair를 화면을 향한 ribbon으로 그린다 (GL 4.3+, hair_ribbon.vert).
+// 정점 attribute 대신 hair VBO를 SSBO로 읽고 (vertex pulling), segment마다 정점 6개를 만들어
+// 색인 없는 glDrawArrays(GL_TRIANGLES) 한 번으로 그린다. geometry shader와 primitive restart를 쓰지 않는다.
+class HairRibbons {
+public:
+    HairRibbons() = default;
+    HairRibbons(const HairRibbons&) = delete;
+    HairRibbons& operator=(const HairRibbons&) = delete;
+
+    // SSBO를 쓸 수 없는 context면 false (호출자는 line으로 그린다)
+    bool init();
+    bool available() const { return vao != 0; }
+
+    // 새 hair로 교체될 때 strand 범위에서 segment 목록을 만든다
+    void setStrands(const HairDrawList& drawList);
+
+    // 앞 strandCount개 strand의 segment를 그린다 (ribbon program이 바인딩된 상태에서 호출)
+    void draw(GLuint vertexBuffer, size_t strandCount);
+
+    // 마지막 draw의 segment 수
+    size_t drawnSegments() const { return lastSegments; }
+
+    // 앞 strandCount개 strand의 segment 수와 segment별 첫 정점 index (SSBO, uint)
+    size_t segmentCount(size_t strandCount) const;
+    GLuint segments() const { return segmentBuffer; }
+
+    void release();
+
+private:
+    GLuint vao = 0;                 // attribute 없는 빈 VAO (core profile은 VAO가 필요)
+    GLuint segmentBuffer = 0;
+    std::vector<size_t> segmentOffsets;  // strand s의 첫 segment (strand 수 + 1개)
+    size_t lastSegments = 0;
+};
+
+#endif
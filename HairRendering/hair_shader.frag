@@ -1,22 +1,31 @@
 ﻿#version 450 core
-in vec3 gsFragPos;
-in vec3 gsU;
-in vec3 gsV;
-in vec3 gsW;
-
-in float gsSinThetaI;
-in float gsSinThetaO;
-in float gsCosThetaI;
-in float gsCosThetaO;
-in float gsCosPhiD; 
-
-in float gsThickness;
-in float gsTransparency;
+// hair_shader.vert (geometry stage를 쓰면 hair_shader.geom)에서 온다
+in HairVarying {
+    vec3 fragPos;
+    vec3 u;
+    vec3 v;
+    vec3 w;
+    float sinThetaI;
+    float sinThetaO;
+    float cosThetaI;
+    float cosThetaO;
+    float cosPhiD;
+    float thickness;
+    float transparency;
+} hair;
 
 layout (location = 0) out vec4 FragColor;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+// 프레임 데이터 (shader_uniforms.h의 FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer 크기 (pixel)
+    float pixelsPerUnit;    // 거리 1에서 길이 1이 차지하는 pixel 수
+};
 uniform float alphaScale;
 uniform int passIndex;
 
@@ -24,12 +33,25 @@ uniform sampler2D marschnerTexture;
 uniform sampler2D NR_texture;
 uniform sampler2D NTT_texture;
 uniform sampler2D NTRT_texture;
+uniform sampler2D N_texture;    // packed: (N_R, A_TT, A_TRT, L_TT)
+uniform sampler2D NL_texture;   // packed: L_TRT
+uniform int lutLayout;          // MarschnerLUTLayout: 0 separate, 1 packed, 2 fitted (texture 없음)
+uniform vec3 absorption;        // sigma_a, LUT에서 빠진 흡수는 여기서 곱한다
+
+// ====== Fitted 모드 (marschner_fit.h) ======
+// M은 Gaussian을 직접 계산하고, N은 cos(theta_d) 두 구간의 Chebyshev 다항식 (FIT_THETA_TERMS x FIT_PHI_TERMS)
+const int FIT_THETA_TERMS = 6;
+const int FIT_PHI_TERMS = 8;
+const int FIT_TERMS = FIT_THETA_TERMS * FIT_PHI_TERMS;
+uniform vec4 fitCoefficients[2 * FIT_TERMS];   // (N_R, log(1 + A_TT), log(1 + A_TRT), L_TT)
+uniform vec4 fitTRTPath[2 * FIT_TERMS / 4];    // L_TRT, 계수 k는 [k / 4][k % 4]
+uniform vec3 lobeAlpha;                         // R, TT, TRT
+uniform vec3 lobeBeta;
 
 // ====== Self-shadowing uniforms ======
 uniform sampler2D depthRangeMap_shadow;   // RG: (min, max)
 uniform usampler2D occupancyMap_shadow;   // RGBA32UI
 uniform sampler2D slabMap_shadow;         // RGBA32F (slab별 fragment 수)
-uniform mat4 lightMVP;
 uniform float shadowWeight;               // e.g., 0.02
 
 //const vec3 hairColor = vec3(0.32, 0.20, 0.09);
@@ -37,34 +59,96 @@ const vec3 hairColor = vec3(0.32, 0.20, 0.09); // Dark brown color
 
 const float PI = 3.1415926535897932384626433832795;
 
+float lobeM(float thetaH, float alpha, float beta) {
+    float shifted = thetaH - alpha;
+    return 1.0 / sqrt(2.0 * PI * beta * beta) * exp(-shifted * shifted / (2.0 * beta * beta));
+}
+
+vec4 fittedN(float cosThetaD, float cosPhiD, out float trtPath) {
+    int base = cosThetaD < 0.0 ? 0 : FIT_TERMS;
+    float x = cosThetaD < 0.0 ? 2.0 * cosThetaD + 1.0 : 2.0 * cosThetaD - 1.0;
+
+    float Tt[FIT_THETA_TERMS];
+    float Tp[FIT_PHI_TERMS];
+    Tt[0] = 1.0; Tt[1] = x;
+    for (int k = 2; k < FIT_THETA_TERMS; ++k) Tt[k] = 2.0 * x * Tt[k - 1] - Tt[k - 2];
+    Tp[0] = 1.0; Tp[1] = cosPhiD;
+    for (int k = 2; k < FIT_PHI_TERMS; ++k) Tp[k] = 2.0 * cosPhiD * Tp[k - 1] - Tp[k - 2];
+
+    vec4 sum = vec4(0.0);
+    trtPath = 0.0;
+    for (int a = 0; a < FIT_THETA_TERMS; ++a) {
+        vec4 row = vec4(0.0);
+        float rowPath = 0.0;
+        for (int b = 0; b < FIT_PHI_TERMS; ++b) {
+            int k = base + a * FIT_PHI_TERMS + b;
+            row += fitCoefficients[k] * Tp[b];
+            rowPath += fitTRTPath[k / 4][k % 4] * Tp[b];
+        }
+        sum += row * Tt[a];
+        trtPath += rowPath * Tt[a];
+    }
+    return sum;
+}
+
 void main(void) {
-    vec3 viewDir = normalize(viewPos - gsFragPos);
-    float angularFade = pow(clamp(dot(viewDir, gsW), 0.0, 1.0), 2.0);
-    float distanceFade = clamp(1.0 - length(viewPos - gsFragPos) * 0.15, 0.0, 1.0);
+    vec3 viewDir = normalize(viewPos - hair.fragPos);
+    float angularFade = pow(clamp(dot(viewDir, hair.w), 0.0, 1.0), 2.0);
+    float distanceFade = clamp(1.0 - length(viewPos - hair.fragPos) * 0.15, 0.0, 1.0);
     float fade = max(angularFade * distanceFade, 0.2);
-    float finalAlpha = clamp(gsTransparency * fade * 3.0, 0.0, 1.0);
+    float finalAlpha = clamp(hair.transparency * fade * 3.0, 0.0, 1.0);
 
     // Marschner scattering lookup
-    vec2 texCoord1 = vec2(clamp((gsSinThetaI + 1.0) * 0.5, 0.0, 1.0), 
-                          clamp((gsSinThetaO + 1.0) * 0.5, 0.0, 1.0));
-    vec4 M_values = texture(marschnerTexture, texCoord1);
+    vec2 texCoord1 = vec2(clamp((hair.sinThetaI + 1.0) * 0.5, 0.0, 1.0), 
+                          clamp((hair.sinThetaO + 1.0) * 0.5, 0.0, 1.0));
+    vec4 M_values;
+    if (lutLayout == 2) {
+        float thetaI = asin(clamp(hair.sinThetaI, -1.0, 1.0));
+        float thetaO = asin(clamp(hair.sinThetaO, -1.0, 1.0));
+        float thetaH = (thetaI + thetaO) * 0.5;
+        M_values = vec4(lobeM(thetaH, lobeAlpha.x, lobeBeta.x), lobeM(thetaH, lobeAlpha.y, lobeBeta.y),
+                        lobeM(thetaH, lobeAlpha.z, lobeBeta.z), cos((thetaO - thetaI) * 0.5));
+    }
+    else {
+        M_values = texture(marschnerTexture, texCoord1);
+    }
     float MR = M_values.r; 
     float MTT = M_values.g;
     float MTRT = M_values.b;
     float CosThetaD = M_values.a;
 
     vec2 texCoordAz = vec2(clamp((CosThetaD + 1.0) * 0.5, 0.0, 1.0), 
-                           clamp((gsCosPhiD + 1.0) * 0.5, 0.0, 1.0));
-    float NR = clamp(texture(NR_texture, texCoordAz).r, 0.0, 1.0);
-    vec3 NTT = clamp(texture(NTT_texture, texCoordAz).rgb, 0.0, 1.0);
-    vec3 NTRT = clamp(texture(NTRT_texture, texCoordAz).rgb, 0.0, 1.0);
+                           clamp((hair.cosPhiD + 1.0) * 0.5, 0.0, 1.0));
+    float NR;
+    vec2 tt, trt;   // (A, L)
+    if (lutLayout == 2) {
+        float trtPath;
+        vec4 N = fittedN(CosThetaD, clamp(hair.cosPhiD, -1.0, 1.0), trtPath);
+        NR = N.r;
+        tt = vec2(exp(N.g) - 1.0, N.a);
+        trt = vec2(exp(N.b) - 1.0, trtPath);
+    }
+    else if (lutLayout == 1) {
+        // TT와 TRT는 근이 달라 L_TRT만 따로 읽는다
+        vec4 N = texture(N_texture, texCoordAz);
+        NR = N.r;
+        tt = N.ga;
+        trt = vec2(N.b, texture(NL_texture, texCoordAz).r);
+    } else {
+        NR = texture(NR_texture, texCoordAz).r;
+        tt = texture(NTT_texture, texCoordAz).rg;
+        trt = texture(NTRT_texture, texCoordAz).rg;
+    }
+    NR = clamp(NR, 0.0, 1.0);
+    vec3 NTT = clamp(tt.x * exp(-absorption * tt.y), 0.0, 1.0);
+    vec3 NTRT = clamp(trt.x * exp(-2.0 * absorption * trt.y), 0.0, 1.0);
 
     float cD2 = CosThetaD * CosThetaD;
     vec3 S = (MR * NR * vec3(1.0) 
             + MTT * NTT * 3.0
             + MTRT * NTRT) *3.0 / cD2 * 0.5;
 
-    float widthFactor = clamp(gsThickness * 5.0, 0.5, 2.0);
+    float widthFactor = clamp(hair.thickness * 5.0, 0.5, 2.0);
     //vec3 shadedColor = gsColor * S * widthFactor;
     vec3 shadedColor = hairColor * S * widthFactor;
     FragColor = vec4(shadedColor, finalAlpha);
@@ -7,47 +7,100 @@ layout (location = 3) in vec3 aWDirection;
 layout (location = 4) in float aThickness;
 layout (location = 5) in float aTransparency;
 
+// 압축 정점 (HairCompactVertex, compactVertices일 때만 사용)
+layout (location = 6) in ivec4 aPackedPosition;  // cluster 기준 snorm16 xyz, v frame 각도 / PI
+layout (location = 7) in ivec2 aPackedTangent;   // octahedral u
+layout (location = 8) in uvec2 aPackedShade;     // unorm16 thickness / thicknessScale, transparency
 
-out vec3 vFragPos; 
-out vec3 vU;
-out vec3 vV;
-out vec3 vW;
-out vec3 vFragNormal;
-out float vSinThetaI;
-out float vSinThetaO;
-out float vCosThetaI;
-out float vCosThetaO;
-out float vCosPhiD; 
-
-out float vThickness;
-out float vTransparency;
-
-uniform mat4 MVP;
-uniform mat4 model;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+
+// fragment (또는 pass-through geometry) stage와 같은 block
+out HairVarying {
+    vec3 fragPos;
+    vec3 u;
+    vec3 v;
+    vec3 w;
+    float sinThetaI;
+    float sinThetaO;
+    float cosThetaI;
+    float cosThetaO;
+    float cosPhiD;
+    float thickness;
+    float transparency;
+} hair;
+
+// 프레임 데이터 (shader_uniforms.h의 FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer 크기 (pixel)
+    float pixelsPerUnit;    // 거리 1에서 길이 1이 차지하는 pixel 수
+};
+
+uniform bool compactVertices;
+uniform samplerBuffer clusterTexture;  // 정점 256개마다 xyz origin, w scale
+uniform float thicknessScale;
+
+const float PI = 3.1415926535897932384626433832795;
+
+vec2 snorm16(ivec2 x) { return max(vec2(x) / 32767.0, -1.0); }
+
+vec3 octDecode(vec2 p) {
+    vec3 n = vec3(p.x, p.y, 1.0 - abs(p.x) - abs(p.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// hair_compact.cpp의 복원과 같은 식
+void unpackVertex(out vec3 position, out vec3 u, out vec3 v, out vec3 w, out float thickness, out float transparency) {
+    vec4 cluster = texelFetch(clusterTexture, gl_VertexID >> 8);
+    position = cluster.xyz + vec3(snorm16(aPackedPosition.xy), snorm16(aPackedPosition.zw).x) * cluster.w;
+
+    u = octDecode(snorm16(aPackedTangent));
+    vec3 t = abs(u.x) > abs(u.z) ? vec3(-u.y, u.x, 0.0) : vec3(0.0, -u.z, u.y);
+    vec3 v0 = normalize(t);
+    vec3 w0 = normalize(cross(u, v0));
+    float angle = snorm16(aPackedPosition.zw).y * PI;
+    v = cos(angle) * v0 + sin(angle) * w0;
+    w = cross(u, v);
+
+    thickness = float(aPackedShade.x) / 65535.0 * thicknessScale;
+    transparency = float(aPackedShade.y) / 65535.0;
+}
 
 void main() {
-    vFragPos = vec3(model * vec4(aPos, 1.0));
+    vec3 position = aPos;
+    vec3 u = aUDirection;
+    vec3 v = aVDirection;
+    vec3 w = aWDirection;
+    float thickness = aThickness;
+    float transparency = aTransparency;
+    if (compactVertices)
+        unpackVertex(position, u, v, w, thickness, transparency);
+
+    hair.fragPos = vec3(model * vec4(position, 1.0));
 
-    vec3 lightDir = normalize(lightPos - vFragPos);
-    vec3 viewDir = normalize(viewPos - vFragPos);
+    vec3 lightDir = normalize(lightPos - hair.fragPos);
+    vec3 viewDir = normalize(viewPos - hair.fragPos);
 
-    vU = normalize(mat3(model) * aUDirection);
-    vV = normalize(mat3(model) * aVDirection);
-    vW = normalize(mat3(model) * aWDirection);
+    hair.u = normalize(mat3(model) * u);
+    hair.v = normalize(mat3(model) * v);
+    hair.w = normalize(mat3(model) * w);
 
-    vSinThetaI = dot(lightDir, vU);
-    vSinThetaO = dot(viewDir, vU);
-    vCosThetaI = dot(lightDir, vW);
-    vCosThetaO = dot(viewDir, vW);
+    hair.sinThetaI = dot(lightDir, hair.u);
+    hair.sinThetaO = dot(viewDir, hair.u);
+    hair.cosThetaI = dot(lightDir, hair.w);
+    hair.cosThetaO = dot(viewDir, hair.w);
 
-    vec3 lightPerp = lightDir - vSinThetaI * vU; 
-    vec3 eyePerp = viewDir - vSinThetaO * vU;
-    vCosPhiD = pow(dot(eyePerp, lightPerp) * dot(eyePerp, eyePerp) * dot(lightPerp, lightPerp), 0.5);
+    vec3 lightPerp = lightDir - hair.sinThetaI * hair.u; 
+    vec3 eyePerp = viewDir - hair.sinThetaO * hair.u;
+    hair.cosPhiD = pow(dot(eyePerp, lightPerp) * dot(eyePerp, eyePerp) * dot(lightPerp, lightPerp), 0.5);
 
-    vThickness = aThickness;
-    vTransparency = aTransparency;
+    hair.thickness = thickness;
+    hair.transparency = transparency;
 
-    gl_Position = MVP * vec4(vFragPos, 1.0);
+    gl_Position = MVP * vec4(hair.fragPos, 1.0);
 }
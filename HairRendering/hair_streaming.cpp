@@ -0,0 +1,98 @@
+﻿#define GLEW_STATIC
+#include "hair_streaming.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+using namespace std;
+
+bool HairStreamer::request(const string& path, HairFrameMode frameMode, HairVertexFormat format) {
+    if (busy()) return false;
+
+    pending = async(launch::async, [path, frameMode, format] {
+        HairLoadResult result;
+        result.path = path;
+        result.hair = loadHairWithCache(path, frameMode);
+        result.continuity = result.hair.continuity;
+        buildHairDrawList(result.hair.model, result.drawList);
+        computeStrandSpheres(static_cast<const float*>(result.hair.gpuData()), result.hair.model, result.strandSpheres);
+        result.format = format;
+
+        if (format == HairVertexFormat::Compact) {
+            const float* full = static_cast<const float*>(result.hair.gpuData());
+            size_t numVertices = result.hair.model.vertexCount();
+            packCompactHairVertices(full, numVertices, result.compact);
+            result.compactError = measureCompactError(full, numVertices, result.compact);
+            result.hair.releaseGpuData();
+
+            cout << "[Hair] compact vertices: " << sizeof(HairCompactVertex) << " B/vertex, max error: position "
+                 << result.compactError.position << ", u " << result.compactError.tangentDegrees << " deg, v "
+                 << result.compactError.frameDegrees << " deg" << endl;
+        }
+        return result;
+    });
+    return true;
+}
+
+float HairStreamer::uploadProgress() const {
+    if (!uploading) return pending.valid() ? 0.0f : 1.0f;
+    size_t total = buffers[1 - frontIndex].size();
+    return total > 0 ? float(double(uploadedBytes) / double(total)) : 1.0f;
+}
+
+bool HairStreamer::update(size_t byteBudget) {
+    if (!uploading) {
+        if (!pending.valid() || pending.wait_for(chrono::seconds(0)) != future_status::ready)
+            return false;
+        back = pending.get();
+        beginUpload();
+    }
+
+    // 이번 프레임 몫만 staging을 거쳐 복사
+    HairVertexBuffer& target = backBuffer();
+    size_t remaining = target.size() - uploadedBytes;
+    size_t chunk = std::min(std::max<size_t>(byteBudget, 1), remaining);
+    if (chunk > 0) {
+        const char* src = static_cast<const char*>(back.gpuData()) + uploadedBytes;
+        staging.copy(src, chunk, target.vbo(), uploadedBytes);
+        uploadedBytes += chunk;
+    }
+    ++uploadFrameCount;
+
+    if (uploadedBytes < target.size())
+        return false;
+
+    finishUpload();
+    return true;
+}
+
+void HairStreamer::beginUpload() {
+    uploading = true;
+    uploadedBytes = 0;
+    uploadFrameCount = 0;
+
+    backBuffer().reserve(back.gpuBytes(), back.format);
+    backBuffer().uploadClusters(back.compact.clusters);
+}
+
+void HairStreamer::finishUpload() {
+    // 복사 명령은 이후 draw보다 먼저 처리되므로 교체 후 바로 그려도 된다
+    // 이전 front는 다음 로드의 back으로 재사용한다
+    frontIndex = 1 - frontIndex;
+    std::swap(front, back);
+    front.hair.releaseGpuData();
+    std::vector<HairCompactVertex>().swap(front.compact.vertices);
+    back = HairLoadResult();
+    uploading = false;
+
+    cout << "[Hair] uploaded " << buffers[frontIndex].size() / (1024.0 * 1024.0) << " MB in "
+         << uploadFrameCount << " frames" << endl;
+}
+
+void HairStreamer::release() {
+    if (pending.valid()) pending.wait();
+    pending = future<HairLoadResult>();
+    buffers[0].destroy();
+    buffers[1].destroy();
+    staging.destroy();
+    uploading = false;
+}
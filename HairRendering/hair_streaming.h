@@ -0,0 +1,76 @@
+﻿#ifndef HAIR_STREAMING_H
+#define HAIR_STREAMING_H
+
+#include <GL/glew.h>
+#include "hair_buffers.h"
+#include "hair_frames.h"
+#include "hair_pack.h"
+#include <future>
+#include <string>
+
+// 백그라운드 로드 결과 (worker thread에서 채움)
+struct HairLoadResult {
+    std::string path;               // 요청한 .hair (읽지 못했으면 hair.model이 비어 있음)
+    LoadedHair hair;
+    HairFrameContinuity continuity;
+    HairDrawList drawList;
+    std::vector<glm::vec4> strandSpheres;
+    HairVertexFormat format = HairVertexFormat::Full;
+    HairCompactData compact;        // Compact일 때 업로드할 정점
+    HairCompactError compactError;
+
+    const void* gpuData() const { return format == HairVertexFormat::Compact ? (const void*)compact.vertices.data() : hair.gpuData(); }
+    size_t gpuBytes() const { return format == HairVertexFormat::Compact ? compact.vertices.size() * sizeof(HairCompactVertex) : hair.gpuBytes(); }
+};
+
+// .hair 로드/전처리는 worker thread에서 하고, 정점 데이터는 staging buffer를 거쳐
+// 프레임당 byteBudget 만큼씩 back 버퍼에 복사한다.
+// 복사가 끝날 때까지 front(이전 hair)를 그리고, 끝난 프레임에 VAO와 모델을 함께 교체한다.
+// front/back 버퍼는 계속 재사용하므로 reload를 반복해도 GPU 메모리가 늘지 않는다.
+class HairStreamer {
+public:
+    HairStreamer() = default;
+    HairStreamer(const HairStreamer&) = delete;
+    HairStreamer& operator=(const HairStreamer&) = delete;
+
+    // 진행 중인 로드가 있으면 false
+    bool request(const std::string& path, HairFrameMode frameMode, HairVertexFormat format = HairVertexFormat::Full);
+
+    // 매 프레임 한 번 호출. 새 hair로 교체된 프레임에 true를 반환한다.
+    bool update(size_t byteBudget);
+
+    bool busy() const { return pending.valid() || uploading; }
+    bool loading() const { return pending.valid(); }
+    float uploadProgress() const;
+    int uploadFrames() const { return uploadFrameCount; }
+
+    // 현재 그리고 있는 hair
+    const HairModel& model() const { return front.hair.model; }
+    const HairDrawList& drawList() const { return front.drawList; }
+    const std::vector<glm::vec4>& strandSpheres() const { return front.strandSpheres; }
+    const HairLoadResult& current() const { return front; }
+    GLuint vao() const { return buffers[frontIndex].vao(); }
+    const HairVertexBuffer& buffer() const { return buffers[frontIndex]; }
+
+    // GL context가 살아 있을 때 호출
+    void release();
+
+private:
+    void beginUpload();
+    void finishUpload();
+    HairVertexBuffer& backBuffer() { return buffers[1 - frontIndex]; }
+
+    std::future<HairLoadResult> pending;
+    HairLoadResult front;
+    HairLoadResult back;
+    HairVertexBuffer buffers[2];
+    int frontIndex = 0;
+
+    bool uploading = false;
+    size_t uploadedBytes = 0;
+    int uploadFrameCount = 0;
+
+    HairStagingBuffer staging;
+};
+
+#endif
@@ -0,0 +1,430 @@
+﻿#include "marschner_batch.h"
+#include "marschner_lut.h"
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__)
+#define MARSCHNER_BATCH_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MARSCHNER_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(MARSCHNER_BATCH_AVX2) || defined(MARSCHNER_BATCH_SSE)
+#define MARSCHNER_BATCH_SIMD
+#endif
+
+using namespace std;
+
+namespace {
+
+const float kPi = 3.14159265358979323846f;
+
+#if defined(MARSCHNER_BATCH_AVX2)
+const char* kernelName = "AVX2";
+const size_t kLanes = 8;
+
+// 비교 결과(mask)도 같은 타입으로 들고 다닌다
+struct vf { __m256 v; };
+
+inline vf vset(float x) { return { _mm256_set1_ps(x) }; }
+inline vf vload(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline void vstore(float* p, vf x) { _mm256_storeu_ps(p, x.v); }
+inline vf operator+(vf a, vf b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline vf operator-(vf a, vf b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline vf operator*(vf a, vf b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline vf operator/(vf a, vf b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline vf operator&(vf a, vf b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline vf operator|(vf a, vf b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline vf operator^(vf a, vf b) { return { _mm256_xor_ps(a.v, b.v) }; }
+inline vf andNot(vf mask, vf b) { return { _mm256_andnot_ps(mask.v, b.v) }; }
+inline vf vsqrt(vf a) { return { _mm256_sqrt_ps(a.v) }; }
+inline vf vmin(vf a, vf b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline vf vmax(vf a, vf b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline vf lessThan(vf a, vf b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline vf greaterThan(vf a, vf b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline vf select(vf mask, vf a, vf b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+
+// 비트 패턴을 3으로 나눠 지수부를 1/3로 만든 초기값 (Kahan의 상수, 상대 오차 <= 3.3%)
+inline vf cbrtGuess(vf x) {
+    __m256i bits = _mm256_castps_si256(x.v);
+    bits = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.0f / 3.0f)));
+    return { _mm256_castsi256_ps(_mm256_add_epi32(bits, _mm256_set1_epi32(0x2a5119f2))) };
+}
+#elif defined(MARSCHNER_BATCH_SSE)
+const char* kernelName = "SSE2";
+const size_t kLanes = 4;
+
+struct vf { __m128 v; };
+
+inline vf vset(float x) { return { _mm_set1_ps(x) }; }
+inline vf vload(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void vstore(float* p, vf x) { _mm_storeu_ps(p, x.v); }
+inline vf operator+(vf a, vf b) { return { _mm_add_ps(a.v, b.v) }; }
+inline vf operator-(vf a, vf b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline vf operator*(vf a, vf b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline vf operator/(vf a, vf b) { return { _mm_div_ps(a.v, b.v) }; }
+inline vf operator&(vf a, vf b) { return { _mm_and_ps(a.v, b.v) }; }
+inline vf operator|(vf a, vf b) { return { _mm_or_ps(a.v, b.v) }; }
+inline vf operator^(vf a, vf b) { return { _mm_xor_ps(a.v, b.v) }; }
+inline vf andNot(vf mask, vf b) { return { _mm_andnot_ps(mask.v, b.v) }; }
+inline vf vsqrt(vf a) { return { _mm_sqrt_ps(a.v) }; }
+inline vf vmin(vf a, vf b) { return { _mm_min_ps(a.v, b.v) }; }
+inline vf vmax(vf a, vf b) { return { _mm_max_ps(a.v, b.v) }; }
+inline vf lessThan(vf a, vf b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline vf greaterThan(vf a, vf b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline vf select(vf mask, vf a, vf b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+
+inline vf cbrtGuess(vf x) {
+    __m128i bits = _mm_castps_si128(x.v);
+    bits = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 3.0f)));
+    return { _mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(0x2a5119f2))) };
+}
+#else
+const char* kernelName = "scalar";
+const size_t kLanes = 0;
+#endif
+
+#if defined(MARSCHNER_BATCH_SIMD)
+inline vf vabs(vf a) { return andNot(vset(-0.0f), a); }
+inline vf vneg(vf a) { return a ^ vset(-0.0f); }
+inline vf copySign(vf magnitude, vf sign) { return andNot(vset(-0.0f), magnitude) | (sign & vset(-0.0f)); }
+
+// x >= 0. 초기값 오차가 3.3% 이내라 Newton 3번이면 float 반올림 오차 (~1 ulp)까지 수렴한다.
+inline vf cbrtPositive(vf x) {
+    const vf third = vset(1.0f / 3.0f);
+    const vf two = vset(2.0f);
+    vf y = cbrtGuess(x);
+    for (int k = 0; k < 3; ++k)
+        y = (two * y + x / (y * y)) * third;
+    return select(greaterThan(x, vset(0.0f)), y, vset(0.0f));
+}
+
+// Abramowitz & Stegun 4.4.46. 다항식 자체의 오차는 2e-8이지만 float로 계산하면
+// 반올림 때문에 |오차| <= 4.1e-7 rad (double acos와 비교해 잰 값)
+inline vf acosApprox(vf x) {
+    vf ax = vabs(x);
+    vf p = vset(-0.0012624911f);
+    p = p * ax + vset(0.0066700901f);
+    p = p * ax + vset(-0.0170881256f);
+    p = p * ax + vset(0.0308918810f);
+    p = p * ax + vset(-0.0501743046f);
+    p = p * ax + vset(0.0889789874f);
+    p = p * ax + vset(-0.2145988016f);
+    p = p * ax + vset(1.5707963050f);
+    vf r = vsqrt(vset(1.0f) - ax) * p;
+    return select(lessThan(x, vset(0.0f)), vset(kPi) - r, r);
+}
+
+// x in [0, pi/3] 에서만 쓰므로 Taylor 급수로 충분하다
+inline void sinCosSmall(vf x, vf& s, vf& c) {
+    vf x2 = x * x;
+    vf ps = vset(-1.0f / 39916800.0f);
+    ps = ps * x2 + vset(1.0f / 362880.0f);
+    ps = ps * x2 + vset(-1.0f / 5040.0f);
+    ps = ps * x2 + vset(1.0f / 120.0f);
+    ps = ps * x2 + vset(-1.0f / 6.0f);
+    s = x + x * x2 * ps;
+
+    vf pc = vset(1.0f / 479001600.0f);
+    pc = pc * x2 + vset(-1.0f / 3628800.0f);
+    pc = pc * x2 + vset(1.0f / 40320.0f);
+    pc = pc * x2 + vset(-1.0f / 720.0f);
+    pc = pc * x2 + vset(1.0f / 24.0f);
+    pc = pc * x2 + vset(-0.5f);
+    c = vset(1.0f) + x2 * pc;
+}
+
+// 복소수 sqrt의 주값 (실수부 >= 0, 허수부 부호는 y를 따름)
+inline void complexSqrt(vf x, vf y, vf& re, vf& im) {
+    const vf zero = vset(0.0f);
+    vf r = vsqrt(x * x + y * y);
+    vf big = vsqrt((r + vabs(x)) * vset(0.5f));
+    vf small = select(greaterThan(big, zero), vabs(y) / (big * vset(2.0f)), zero);
+    vf negative = lessThan(x, zero);
+    re = select(negative, small, big);
+    im = copySign(select(negative, big, small), y);
+}
+
+// solveGammaI에서 phi_d와 무관한 값
+struct CubicRow {
+    int p;
+    bool linear;        // |a| < 1e-6: 1차식
+    bool solvable;
+    float a, b;
+    float pPi;          // (p pi) mod 2pi
+    float pThird;       // P/3
+    float P3;           // (P/3)^3
+    float phiSlope;     // evaluate_phi_hat의 1차 계수
+    float phiCubic;     // 3차 계수
+};
+
+CubicRow makeCubicRow(int p, float c) {
+    CubicRow row;
+    row.p = p;
+    row.a = (8.0f * p * c) / pow(kPi, 3.0f);
+    row.b = -((6.0f * p * c) / kPi - 2.0f);
+    row.pPi = (p % 2) * kPi;
+    row.linear = fabs(row.a) < 1e-6f;
+    row.solvable = !row.linear || fabs(row.b) >= 1e-6f;
+    row.pThird = row.linear ? 0.0f : row.b / row.a / 3.0f;
+    row.P3 = float(pow(double(row.pThird), 3));
+    row.phiSlope = (6.0f * p * c) / kPi - 2.0f;
+    row.phiCubic = (8.0f * p * c) / (kPi * kPi * kPi);
+    return row;
+}
+
+// 후보 근 하나를 solveGammaI와 같은 규칙으로 비교
+struct RootPicker {
+    const CubicRow& row;
+    vf phi;
+    vf best = vset(numeric_limits<float>::quiet_NaN());
+    vf minErr = vset(1e10f);
+    vf minMagnitude = vset(100.0f);
+
+    RootPicker(const CubicRow& r, vf phi_d) : row(r), phi(phi_d) {}
+
+    void consider(vf re, vf im) {
+        vf real = andNot(greaterThan(vabs(re), vset(kMaxGammaI)), lessThan(vabs(im), vset(1e-2f)));
+        vf phiHat = vset(row.phiSlope) * re - vset(row.phiCubic) * (re * re * re) + vset(row.pPi);
+        vf err = vabs(phiHat - phi);
+
+        vf take;
+        if (row.p == 2) {
+            take = real & lessThan(err, vset(0.3f)) & lessThan(vabs(re), minMagnitude);
+            minMagnitude = select(take, vabs(re), minMagnitude);
+        }
+        else {
+            take = real & lessThan(err, minErr);
+        }
+        best = select(take, re, best);
+        minErr = select(take, err, minErr);
+    }
+};
+
+// marschner_lut.cpp의 polishRoot
+vf polishRoot(const CubicRow& row, vf cc, vf x) {
+    vf a = vset(row.a);
+    vf b = vset(row.b);
+    vf step = (a * x * x * x + b * x + cc) / (vset(3.0f) * a * x * x + b);
+    return select(lessThan(vabs(step), vset(kMaxRootPolish)), x - step, x);
+}
+
+// solveCubic의 세 근 x1, x2, x3을 실수 연산으로 계산한다.
+// delta >= 0: u^3, v^3이 실수. 실수 세제곱근을 쓰고, 큰 쪽 v만 구해 u = -P / (3v)로 상쇄 오차를 피한다.
+// delta < 0:  u^3, v^3이 켤레 복소수. u = rho * e^(i theta/3), v = conj(u) (삼각 형태)
+vf solveGammaIBlock(const CubicRow& row, vf phi) {
+    RootPicker picker(row, phi);
+    vf cc = phi - vset(row.pPi);
+
+    if (row.linear) {
+        if (row.solvable)
+            picker.consider(vneg(cc) / vset(row.b), vset(0.0f));
+        return picker.best;
+    }
+
+    const vf zero = vset(0.0f);
+    const vf s3 = vset(float(sqrt(3) / 2.0));
+
+    vf q = cc / vset(row.a);
+    vf halfQ = vneg(q) / vset(2.0f);
+    vf delta = (q / vset(2.0f)) * (q / vset(2.0f)) + vset(row.P3);
+
+    vf vCubed = halfQ - copySign(vsqrt(vmax(delta, zero)), q);
+    vf vr = copySign(cbrtPositive(vabs(vCubed)), vCubed);
+    vf vi = zero;
+    vf ur = select(greaterThan(vabs(vr), zero), vneg(vset(row.pThird)) / vr, zero);
+    vf ui = zero;
+
+    vf threeReal = lessThan(delta, zero);
+    vf w = vsqrt(halfQ * halfQ - delta);    // |u^3|
+    vf rho = cbrtPositive(w);
+    vf cosTheta = vmax(vset(-1.0f), vmin(vset(1.0f), halfQ / w));
+    vf s, c;
+    sinCosSmall(acosApprox(cosTheta) * vset(1.0f / 3.0f), s, c);
+    ur = select(threeReal, rho * c, ur);
+    ui = select(threeReal, rho * s, ui);
+    vr = select(threeReal, rho * c, vr);
+    vi = select(threeReal, vneg(rho * s), vi);
+
+    // x1 = u + v, x2 = u w1 + v w2, x3 = u w2 + v w1  (w1 = -1/2 + i s3, w2 = conj(w1))
+    vf mh = vset(-0.5f);
+    vf ms3 = vneg(s3);
+    picker.consider(ur + vr, ui + vi);
+    picker.consider((ur * mh - ui * s3) + (vr * mh - vi * ms3), (ur * s3 + ui * mh) + (vr * ms3 + vi * mh));
+    picker.consider((ur * mh - ui * ms3) + (vr * mh - vi * s3), (ur * ms3 + ui * mh) + (vr * s3 + vi * mh));
+    return polishRoot(row, cc, picker.best);
+}
+
+// FresnelReflectance와 같은 식: eta = (eta', eta'')인 복소 굴절률, cos(theta_i) 자리에 gamma
+vf fresnelBlock(vf g, float etaPrime, float etaDoublePrime) {
+    const vf zero = vset(0.0f);
+    const vf one = vset(1.0f);
+    const vf e1 = vset(etaPrime);
+    const vf e2 = vset(etaDoublePrime);
+
+    // sinI = sqrt(1 - cosI^2), cosI = gamma는 실수
+    vf sinIr, sinIi;
+    complexSqrt(one - g * g, zero, sinIr, sinIi);
+
+    // sinT = sinI / eta
+    vf etaNorm = e1 * e1 + e2 * e2;
+    vf sinTr = (sinIr * e1 + sinIi * e2) / etaNorm;
+    vf sinTi = (sinIi * e1 - sinIr * e2) / etaNorm;
+
+    // cosT = sqrt(1 - sinT^2)
+    vf cosTr, cosTi;
+    complexSqrt(one - (sinTr * sinTr - sinTi * sinTi), zero - (sinTr * sinTi + sinTi * sinTr), cosTr, cosTi);
+
+    // |Rs|^2 = |eta cosI - cosT|^2 / |eta cosI + cosT|^2
+    vf ecr = e1 * g;
+    vf eci = e2 * g;
+    vf sNr = ecr - cosTr, sNi = eci - cosTi;
+    vf sDr = ecr + cosTr, sDi = eci + cosTi;
+    vf Rs = (sNr * sNr + sNi * sNi) / (sDr * sDr + sDi * sDi);
+
+    // |Rp|^2 = |cosI - eta cosT|^2 / |cosI + eta cosT|^2
+    vf etr = e1 * cosTr - e2 * cosTi;
+    vf eti = e1 * cosTi + e2 * cosTr;
+    vf pNr = g - etr, pNi = zero - eti;
+    vf pDr = g + etr, pDi = zero + eti;
+    vf Rp = (pNr * pNr + pNi * pNi) / (pDr * pDr + pDi * pDi);
+
+    return vset(0.5f) * (Rs + Rp);
+}
+#endif
+
+template <typename Block>
+void forEachBlock(const float* in, size_t count, float* out, const Block& block) {
+#if defined(MARSCHNER_BATCH_SIMD)
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes)
+        vstore(out + i, block(vload(in + i)));
+
+    // 남은 sample은 0으로 채운 묶음 하나로 처리
+    if (i < count) {
+        float tailIn[kLanes] = {};
+        float tailOut[kLanes];
+        for (size_t k = i; k < count; ++k) tailIn[k - i] = in[k];
+        vstore(tailOut, block(vload(tailIn)));
+        for (size_t k = i; k < count; ++k) out[k] = tailOut[k - i];
+    }
+#endif
+}
+
+double elapsedMs(const function<void()>& fn) {
+    auto start = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+const char* marschnerBatchKernel() {
+    return kernelName;
+}
+
+void solveGammaIBatch(const float* phi_d, size_t count, int p, float c, float* gamma_i) {
+#if defined(MARSCHNER_BATCH_SIMD)
+    CubicRow row = makeCubicRow(p, c);
+    forEachBlock(phi_d, count, gamma_i, [&](vf phi) { return solveGammaIBlock(row, phi); });
+#else
+    for (size_t i = 0; i < count; ++i)
+        gamma_i[i] = solveGammaI(phi_d[i], p, c);
+#endif
+}
+
+void fresnelReflectanceBatch(const float* gamma, size_t count, float etaPrime, float etaDoublePrime, float* F) {
+#if defined(MARSCHNER_BATCH_SIMD)
+    forEachBlock(gamma, count, F, [&](vf g) { return fresnelBlock(g, etaPrime, etaDoublePrime); });
+#else
+    for (size_t i = 0; i < count; ++i)
+        F[i] = FresnelReflectance(gamma[i], etaPrime, etaDoublePrime);
+#endif
+}
+
+MarschnerBatchReport validateMarschnerBatch(int size, float eta) {
+    MarschnerBatchReport report;
+    report.kernel = kernelName;
+
+    vector<float> phi_d(size), gamma(size);
+    for (int j = 0; j < size; j++)
+        phi_d[j] = acosf(-1.0f + 2.0f * (float)j / (size - 1));
+    for (int j = 0; j < size; j++)
+        gamma[j] = -0.5f * kPi + kPi * (float)j / (size - 1);
+
+    // LUT와 같은 theta_d 줄마다 eta', eta'', c
+    vector<float> etaPrime(size), etaDoublePrime(size), c(size);
+    for (int i = 0; i < size; i++) {
+        float theta_d = acosf(-1.0f + 2.0f * (float)i / (size - 1));
+        etaPrime[i] = computeEtaPrime(eta, theta_d);
+        etaDoublePrime[i] = computeEtaDoublePrime(eta, theta_d);
+        c[i] = asinf(1.0f / etaPrime[i]);
+    }
+
+    size_t total = size_t(size) * size_t(size);
+    vector<float> scalarOut(total), batchOut(total);
+
+    // N_R은 p = 0, N_TT는 p = 1, N_TRT는 p = 2
+    for (int p : { 0, 1, 2 }) {
+        report.scalarCubicMs += elapsedMs([&] {
+            for (int i = 0; i < size; i++)
+                for (int j = 0; j < size; j++)
+                    scalarOut[size_t(i) * size + j] = solveGammaI(phi_d[j], p, c[i]);
+        });
+        report.batchCubicMs += elapsedMs([&] {
+            for (int i = 0; i < size; i++)
+                solveGammaIBatch(phi_d.data(), size, p, c[i], &batchOut[size_t(i) * size]);
+        });
+
+        for (size_t k = 0; k < total; ++k) {
+            bool scalarNaN = std::isnan(scalarOut[k]);
+            bool batchNaN = std::isnan(batchOut[k]);
+            float diff = fabs(scalarOut[k] - batchOut[k]);
+            if (scalarNaN != batchNaN || diff > 1e-3f) {
+                report.rootMismatches++;
+            }
+            else if (!scalarNaN) {
+                report.maxGammaError = std::max(report.maxGammaError, diff);
+            }
+        }
+        report.samples += total;
+    }
+
+    // 두 번째 Fresnel(N_TRT)은 1/eta', 1/eta''로 부른다
+    for (bool inverse : { false, true }) {
+        auto etaPair = [&](int i, float& e1, float& e2) {
+            e1 = inverse ? 1.0f / etaPrime[i] : etaPrime[i];
+            e2 = inverse ? 1.0f / etaDoublePrime[i] : etaDoublePrime[i];
+        };
+        report.scalarFresnelMs += elapsedMs([&] {
+            for (int i = 0; i < size; i++) {
+                float e1, e2;
+                etaPair(i, e1, e2);
+                for (int j = 0; j < size; j++)
+                    scalarOut[size_t(i) * size + j] = FresnelReflectance(gamma[j], e1, e2);
+            }
+        });
+        report.batchFresnelMs += elapsedMs([&] {
+            for (int i = 0; i < size; i++) {
+                float e1, e2;
+                etaPair(i, e1, e2);
+                fresnelReflectanceBatch(gamma.data(), size, e1, e2, &batchOut[size_t(i) * size]);
+            }
+        });
+
+        for (size_t k = 0; k < total; ++k) {
+            if (std::isnan(scalarOut[k]) != std::isnan(batchOut[k])) report.fresnelMismatches++;
+            if (std::isnan(scalarOut[k]) || std::isnan(batchOut[k])) continue;
+            // 분모가 0에 가까운 곳은 값이 커지므로 상대 오차로 본다
+            float diff = fabs(scalarOut[k] - batchOut[k]) / std::max(1.0f, fabs(scalarOut[k]));
+            report.maxFresnelError = std::max(report.maxFresnelError, diff);
+        }
+    }
+
+    return report;
+}
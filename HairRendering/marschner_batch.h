@@ -0,0 +1,45 @@
+﻿#ifndef MARSCHNER_BATCH_H
+#define MARSCHNER_BATCH_H
+
+#include <cstddef>
+
+// solveGammaI / FresnelReflectance의 SIMD batch 버전 (AVX2 8개, SSE2 4개씩).
+// LUT 한 줄(theta_d 고정)의 phi_d를 묶어서 풀기 때문에 c, eta', eta''는 줄마다 상수로 받는다.
+// std::complex 없이 실수 연산으로 같은 식을 풀고, 근 선택 규칙도 스칼라 코드와 같다.
+const char* marschnerBatchKernel();
+
+void solveGammaIBatch(const float* phi_d, size_t count, int p, float c, float* gamma_i);
+void fresnelReflectanceBatch(const float* gamma, size_t count, float etaPrime, float etaDoublePrime, float* F);
+
+// 스칼라 코드와의 비교 허용치. LUT는 half로 저장하므로 half의 상대 반올림 오차 (4.9e-4)보다 작게 잡는다.
+// 이보다 크게 다르면 (AVX2는 FMA로 묶여 Fresnel이 5e-5까지 다르다) 커널이 잘못된 것으로 본다.
+const float kMarschnerBatchGammaTolerance = 1e-4f;     // radian
+const float kMarschnerBatchFresnelTolerance = 2e-4f;   // 상대 오차
+// 근 선택 규칙의 경계 (|gamma_i| 한계, 허수부 1e-2, p = 2의 오차 0.3)에 걸린 sample은 반올림에 따라
+// 양쪽이 다른 근 (또는 NaN)을 고를 수 있어서 이 비율까지는 허용한다 (1024^2에서 3e-7 정도 나온다).
+const double kMarschnerBatchRootMismatchRate = 1e-5;
+
+// 스칼라 코드와의 비교 (LUT와 같은 size x size 격자, 한 스레드)
+struct MarschnerBatchReport {
+    const char* kernel = "";
+    size_t samples = 0;
+    size_t rootMismatches = 0;      // NaN 여부가 다르거나 다른 근을 고른 sample
+    float maxGammaError = 0.0f;     // 같은 근을 고른 sample의 최대 차이 (radian)
+    size_t fresnelMismatches = 0;   // NaN 여부가 다른 sample
+    float maxFresnelError = 0.0f;   // 상대 오차
+    double scalarCubicMs = 0.0;
+    double batchCubicMs = 0.0;
+    double scalarFresnelMs = 0.0;
+    double batchFresnelMs = 0.0;
+
+    bool passed() const {
+        return rootMismatches <= samples * kMarschnerBatchRootMismatchRate && fresnelMismatches == 0 &&
+               maxGammaError <= kMarschnerBatchGammaTolerance && maxFresnelError <= kMarschnerBatchFresnelTolerance;
+    }
+    double cubicSpeedup() const { return scalarCubicMs / (batchCubicMs > 0.0 ? batchCubicMs : 1e-6); }
+    double fresnelSpeedup() const { return scalarFresnelMs / (batchFresnelMs > 0.0 ? batchFresnelMs : 1e-6); }
+};
+
+MarschnerBatchReport validateMarschnerBatch(int size, float eta);
+
+#endif
@@ -0,0 +1,210 @@
+﻿#include "marschner_cache.h"
+#include "hair_pack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+namespace {
+
+const int kChannels[kMarschnerLUTCount] = { kLUTChannelsM, kLUTChannelsNR, kLUTChannelsNTT, kLUTChannelsNTRT };
+
+// float -> half, round to nearest even
+uint16_t floatToHalf(float value) {
+    const uint32_t f16Max = (127 + 16) << 23;
+    const uint32_t f32Infinity = 255 << 23;
+    const uint32_t denormMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= f16Max) {
+        half = bits > f32Infinity ? 0x7e00 : 0x7c00;    // NaN, Inf (overflow 포함)
+    }
+    else if (bits < (113u << 23)) {
+        // subnormal / 0: magic 값을 더해 mantissa를 맨 아래로 맞추면 FPU가 반올림해 준다
+        float magic, shifted;
+        memcpy(&magic, &denormMagicBits, 4);
+        memcpy(&shifted, &bits, 4);
+        shifted += magic;
+        memcpy(&half, &shifted, 4);
+        half -= denormMagicBits;
+    }
+    else {
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += (uint32_t(15 - 127) << 23) + 0xfff + mantissaOdd;
+        half = bits >> 13;
+    }
+    return uint16_t(half | (sign >> 16));
+}
+
+void toHalves(const vector<float>& in, uint16_t* out) {
+    for (size_t i = 0; i < in.size(); ++i)
+        out[i] = floatToHalf(in[i]);
+}
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+size_t MarschnerLUTData::offset(int lut) const {
+    size_t texels = size_t(size) * size_t(size);
+    size_t offset = 0;
+    for (int k = 0; k < lut; ++k)
+        offset += texels * kChannels[k];
+    return offset;
+}
+
+int marschnerLUTChannels(int lut) {
+    return kChannels[lut];
+}
+
+void packMarschnerN(const MarschnerLUTData& data, uint16_t* out) {
+    const uint16_t* NR = data.table(1);
+    const uint16_t* NTT = data.table(2);
+    const uint16_t* NTRT = data.table(3);
+    size_t texels = size_t(data.size) * size_t(data.size);
+    uint16_t* L_TRT = out + texels * kLUTChannelsPackedN;
+    for (size_t t = 0; t < texels; ++t) {
+        out[t * 4 + 0] = NR[t];
+        out[t * 4 + 1] = NTT[t * 2];
+        out[t * 4 + 2] = NTRT[t * 2];
+        out[t * 4 + 3] = NTT[t * 2 + 1];
+        L_TRT[t] = NTRT[t * 2 + 1];
+    }
+}
+
+uint64_t hashMarschnerParams(const MarschnerParams& params, int size) {
+    const float key[] = {
+        params.eta,
+        params.alphaR, params.alphaTT, params.alphaTRT,
+        params.betaR, params.betaTT, params.betaTRT,
+        float(size), float(kMarschnerCacheVersion)
+    };
+    return hashBytes(reinterpret_cast<const unsigned char*>(key), sizeof(key));
+}
+
+// 실행 폴더에 marschner_<hash>.mlut
+string marschnerCachePath(const MarschnerParams& params, int size) {
+    ostringstream name;
+    name << "marschner_" << hex << hashMarschnerParams(params, size) << ".mlut";
+    return name.str();
+}
+
+void buildMarschnerLUTs(int size, const MarschnerParams& params, MarschnerLUTData& out) {
+    out.size = size;
+    out.halves.resize(out.offset(kMarschnerLUTCount));
+
+    vector<float> data(lutFloatCount(size, kLUTChannelsM));
+    void (*compute[kMarschnerLUTCount])(int, const MarschnerParams&, float*, unsigned) = {
+        computeM_LUT, computeNR_LUT, computeNTT_LUT, computeNTRT_LUT
+    };
+    for (int k = 0; k < kMarschnerLUTCount; ++k) {
+        data.resize(lutFloatCount(size, kChannels[k]));
+        compute[k](size, params, data.data(), 0);
+        toHalves(data, out.halves.data() + out.offset(k));
+    }
+}
+
+bool readMarschnerCache(const string& path, uint64_t paramsHash, int size, MarschnerLUTData& out) {
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    MarschnerCacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (strncmp(header.magic, "MLUT", 4) != 0 || header.version != kMarschnerCacheVersion ||
+        header.paramsHash != paramsHash || header.size != uint32_t(size))
+        return false;
+    for (int k = 0; k < kMarschnerLUTCount; ++k)
+        if (header.channels[k] != uint32_t(kChannels[k])) return false;
+
+    // 네 LUT를 한 번에 읽는다
+    out.size = size;
+    out.halves.resize(out.offset(kMarschnerLUTCount));
+    size_t bytes = out.halves.size() * sizeof(uint16_t);
+    if (!in.read(reinterpret_cast<char*>(out.halves.data()), bytes) || size_t(in.gcount()) != bytes) {
+        out.halves.clear();
+        return false;
+    }
+    return true;
+}
+
+bool writeMarschnerCache(const string& path, uint64_t paramsHash, const MarschnerLUTData& data) {
+    MarschnerCacheHeader header = {};
+    memcpy(header.magic, "MLUT", 4);
+    header.version = kMarschnerCacheVersion;
+    header.paramsHash = paramsHash;
+    header.size = uint32_t(data.size);
+    for (int k = 0; k < kMarschnerLUTCount; ++k)
+        header.channels[k] = uint32_t(kChannels[k]);
+
+    // .hairpack과 같이 임시 파일에 쓰고 교체
+    string tempPath = path + ".tmp";
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        if (!out) {
+            cerr << "Failed to write LUT cache: " << tempPath << endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data.halves.data()), data.halves.size() * sizeof(uint16_t));
+        if (!out) {
+            cerr << "Failed to write LUT cache: " << tempPath << endl;
+            return false;
+        }
+    }
+
+    remove(path.c_str());
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        cerr << "Failed to replace LUT cache: " << path << endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+MarschnerLUTData loadMarschnerLUTsWithCache(int size, const MarschnerParams& params) {
+    MarschnerLUTData result;
+    auto start = chrono::steady_clock::now();
+
+    uint64_t hash = hashMarschnerParams(params, size);
+    string path = marschnerCachePath(params, size);
+    result.fromCache = readMarschnerCache(path, hash, size, result);
+    if (!result.fromCache) {
+        buildMarschnerLUTs(size, params, result);
+        writeMarschnerCache(path, hash, result);
+    }
+
+    result.milliseconds = elapsedMs(start);
+    cout << "[LUT] " << path << ": " << (result.fromCache ? "warm (cache hit)" : "cold (cache miss)")
+         << " in " << result.milliseconds << " ms" << endl;
+    return result;
+}
+
+LUTCacheTimings timeLUTCache(int size, const MarschnerParams& params) {
+    LUTCacheTimings timings;
+    uint64_t hash = hashMarschnerParams(params, size);
+    string path = marschnerCachePath(params, size) + ".bench";
+
+    auto start = chrono::steady_clock::now();
+    MarschnerLUTData data;
+    buildMarschnerLUTs(size, params, data);
+    writeMarschnerCache(path, hash, data);
+    timings.cold = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    MarschnerLUTData cached;
+    readMarschnerCache(path, hash, size, cached);
+    timings.warm = elapsedMs(start);
+
+    remove(path.c_str());
+    return timings;
+}
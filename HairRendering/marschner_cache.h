@@ -0,0 +1,67 @@
+﻿#ifndef MARSCHNER_CACHE_H
+#define MARSCHNER_CACHE_H
+
+#include "marschner_lut.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// LUT 캐시 (.mlut).
+// 네 LUT를 M, NR, NTT, NTRT 순서로 half float 그대로 이어 저장해서 texture에 바로 올린다.
+// 파일 이름과 헤더에 파라미터 hash가 들어가므로 파라미터가 바뀌면 miss가 난다.
+// LUT 계산 식이 바뀌면 kMarschnerCacheVersion을 올린다.
+const uint32_t kMarschnerCacheVersion = 3;
+const int kMarschnerLUTCount = 4;
+
+struct MarschnerCacheHeader {
+    char magic[4];                          // "MLUT"
+    uint32_t version;
+    uint64_t paramsHash;
+    uint32_t size;
+    uint32_t channels[kMarschnerLUTCount];  // M, NR, NTT, NTRT
+    uint32_t reserved;
+};
+
+static_assert(sizeof(MarschnerCacheHeader) == 40, "unexpected .mlut header padding");
+
+// half float LUT 네 장
+struct MarschnerLUTData {
+    int size = 0;
+    std::vector<uint16_t> halves;
+    bool fromCache = false;
+    double milliseconds = 0.0;
+
+    size_t offset(int lut) const;
+    const uint16_t* table(int lut) const { return halves.data() + offset(lut); }
+};
+
+int marschnerLUTChannels(int lut);
+
+// NR, NTT, NTRT를 합친 배치: RGBA (N_R, A_TT, A_TRT, L_TT) 한 장과 R (L_TRT) 한 장.
+// TT와 TRT는 γi 근이 달라 L도 다르므로 다섯 번째 값은 따로 둔다.
+// out에는 RGBA 배치 뒤에 L_TRT 배치를 이어 쓴다 (lutFloatCount(size, kLUTChannelsPackedN + kLUTChannelsPackedL)개).
+const int kLUTChannelsPackedN = 4;
+const int kLUTChannelsPackedL = 1;
+void packMarschnerN(const MarschnerLUTData& data, uint16_t* out);
+
+uint64_t hashMarschnerParams(const MarschnerParams& params, int size);
+std::string marschnerCachePath(const MarschnerParams& params, int size);
+
+// 캐시 없이 계산만 (thread pool 사용)
+void buildMarschnerLUTs(int size, const MarschnerParams& params, MarschnerLUTData& out);
+
+bool readMarschnerCache(const std::string& path, uint64_t paramsHash, int size, MarschnerLUTData& out);
+bool writeMarschnerCache(const std::string& path, uint64_t paramsHash, const MarschnerLUTData& data);
+
+// 캐시가 맞으면 읽기만 하고, 아니면 계산한 뒤 캐시를 쓴다.
+MarschnerLUTData loadMarschnerLUTsWithCache(int size, const MarschnerParams& params);
+
+// 임시 캐시 파일로 cold(계산 + 쓰기) / warm(읽기) 시간을 잰다 (ms)
+struct LUTCacheTimings {
+    double cold = 0.0;
+    double warm = 0.0;
+};
+
+LUTCacheTimings timeLUTCache(int size, const MarschnerParams& params);
+
+#endif
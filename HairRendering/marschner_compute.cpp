@@ -0,0 +1,219 @@
+﻿#define GLEW_STATIC
+#include "marschner_compute.h"
+#include "marschner_cache.h"
+#include "marschner_texture.h"
+#include "shader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+using namespace std;
+
+namespace {
+
+const GLuint kLocalSize = 8;
+const GLenum kInternalFormats[] = { GL_RGBA16F, GL_R16F, GL_RG16F, GL_RG16F, GL_RGBA16F, GL_R16F };
+const GLenum kFormats[] = { GL_RGBA, GL_RED, GL_RG, GL_RG, GL_RGBA, GL_RED };
+const int kChannels[] = {
+    kLUTChannelsM, kLUTChannelsNR, kLUTChannelsNTT, kLUTChannelsNTRT, kLUTChannelsPackedN, kLUTChannelsPackedL
+};
+
+void allocate(GLuint& texture, int size, int k) {
+    if (texture) glDeleteTextures(1, &texture);
+    uploadLUT(texture, size, kInternalFormats[k], kFormats[k], nullptr, GL_HALF_FLOAT);
+}
+
+}
+
+bool MarschnerLUTCompute::init(const char* computeShaderPath) {
+    if (!GLEW_VERSION_4_3) {
+        cerr << "[LUT] GL 4.3 is not available, GPU LUT generation disabled" << endl;
+        return false;
+    }
+
+    program = loadComputeShader(computeShaderPath);
+    if (!program) return false;
+
+    sizeLoc = glGetUniformLocation(program, "size");
+    etaLoc = glGetUniformLocation(program, "eta");
+    alphaLoc = glGetUniformLocation(program, "alpha");
+    betaLoc = glGetUniformLocation(program, "beta");
+    return true;
+}
+
+void MarschnerLUTCompute::dispatch(const GLuint textures[kTextures], int size, const MarschnerParams& params) {
+    glUseProgram(program);
+    glUniform1i(sizeLoc, size);
+    glUniform1f(etaLoc, params.eta);
+    glUniform3f(alphaLoc, params.alphaR, params.alphaTT, params.alphaTRT);
+    glUniform3f(betaLoc, params.betaR, params.betaTT, params.betaTRT);
+    for (int k = 0; k < kTextures; ++k)
+        glBindImageTexture(k, textures[k], 0, GL_FALSE, 0, GL_WRITE_ONLY, kInternalFormats[k]);
+
+    GLuint groups = (GLuint(size) + kLocalSize - 1) / kLocalSize;
+    glDispatchCompute(groups, groups, 1);
+
+    // 이후 draw의 texture fetch와 glGetTexImage가 결과를 보도록
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    for (int k = 0; k < kTextures; ++k)
+        glBindImageTexture(k, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, kInternalFormats[k]);
+    glUseProgram(0);
+}
+
+void MarschnerLUTCompute::build(int size, const MarschnerParams& params) {
+    if (!available()) return;
+
+    GLuint* textures[kTextures] = { &marschnerTex, &NR_tex, &NTT_tex, &NTRT_tex, &N_tex, &NL_tex };
+    GLint width = 0;
+    if (marschnerTex) {
+        glBindTexture(GL_TEXTURE_2D, marschnerTex);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (width != size) {
+        for (int k = 0; k < kTextures; ++k)
+            allocate(*textures[k], size, k);
+    }
+
+    GLuint handles[kTextures];
+    for (int k = 0; k < kTextures; ++k) handles[k] = *textures[k];
+    dispatch(handles, size, params);
+}
+
+namespace {
+
+// 상하좌우 이웃 texel의 같은 채널 기준값. 격자 밖은 빼고 개수를 돌려준다.
+int gatherNeighbours(const uint16_t* reference, size_t index, int size, int channels, float neighbours[4]) {
+    int texel = int(index / channels);
+    int column = texel % size, row = texel / size;
+    const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    int count = 0;
+    for (const auto& offset : offsets) {
+        int x = column + offset[0], y = row + offset[1];
+        if (x < 0 || y < 0 || x >= size || y >= size) continue;
+        neighbours[count++] = glm::unpackHalf1x16(reference[size_t(y * size + x) * channels + index % channels]);
+    }
+    return count;
+}
+
+// kMarschnerCausticAmplitude를 넘거나, 이웃보다 kMarschnerCausticPeakRatio배 이상 튀어나온 봉우리.
+// A_TRT는 F_t가 곱해져 caustic 봉우리도 64에 못 미치는 경우가 많다.
+bool isCaustic(float expected, const float neighbours[4], int count) {
+    float magnitude = std::fabs(expected);
+    if (magnitude >= kMarschnerCausticAmplitude) return true;
+    if (!(magnitude >= 1.0f)) return false;
+    for (int n = 0; n < count; ++n)
+        if (std::isfinite(neighbours[n]) && std::fabs(neighbours[n]) * kMarschnerCausticPeakRatio > magnitude) return false;
+    return true;
+}
+
+bool closeEnough(float expected, float actual, float tolerance) {
+    if (!std::isfinite(expected) || !std::isfinite(actual))
+        return std::isnan(expected) == std::isnan(actual) && std::isinf(expected) == std::isinf(actual);
+    return std::fabs(actual - expected) / std::max(1.0f, std::fabs(expected)) <= tolerance;
+}
+
+// caustic 옆 (겹근 근처)에서는 c, phi_d의 1e-6 rad 오차도 근을 크게 옮긴다 (GPU의 atan은 그 정도 틀린다).
+// 근 선택 경계 (근이 생기고 없어지는 곳)가 한 texel 밀리거나 급경사에서 값이 달라져도,
+// 이웃 기준값과 맞거나 그 사이에 있으면 한 texel 안쪽의 입력 오차로 설명되므로 불일치로 세지 않는다.
+// 한쪽만 NaN이면 NaN 경계가 밀린 것이라 유한/NaN 여부가 같은 이웃이 있으면 된다.
+bool withinNeighbours(float expected, float actual, const float neighbours[4], int count, float tolerance) {
+    if (!std::isfinite(expected) || !std::isfinite(actual)) {
+        for (int n = 0; n < count; ++n)
+            if (std::isfinite(neighbours[n]) == std::isfinite(actual)) return true;
+        return false;
+    }
+    float low = expected, high = expected;
+    for (int n = 0; n < count; ++n) {
+        if (closeEnough(neighbours[n], actual, tolerance)) return true;
+        low = std::min(low, neighbours[n]);
+        high = std::max(high, neighbours[n]);
+    }
+    return std::isfinite(low) && std::isfinite(high) && actual >= low && actual <= high;
+}
+
+// CPU 기준값을 만들어 GPU에서 읽어 온 texture와 비교한다. GL을 쓰지 않으므로 worker thread에서 돈다.
+MarschnerComputeReport compareWithReference(MarschnerComputeReport report, const MarschnerParams& params,
+                                            const vector<vector<uint16_t>>& gpu) {
+    auto start = chrono::steady_clock::now();
+    MarschnerLUTData cpu;
+    buildMarschnerLUTs(report.size, params, cpu);
+    report.cpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    vector<uint16_t> packed(lutFloatCount(report.size, kLUTChannelsPackedN + kLUTChannelsPackedL));
+    packMarschnerN(cpu, packed.data());
+    const uint16_t* references[] = {
+        cpu.table(0), cpu.table(1), cpu.table(2), cpu.table(3),
+        packed.data(), packed.data() + lutFloatCount(report.size, kLUTChannelsPackedN)
+    };
+
+    for (size_t k = 0; k < gpu.size(); ++k) {
+        const uint16_t* reference = references[k];
+        for (size_t i = 0; i < gpu[k].size(); ++i) {
+            float expected = glm::unpackHalf1x16(reference[i]);
+            float actual = glm::unpackHalf1x16(gpu[k][i]);
+            float neighbours[4];
+            int count = gatherNeighbours(reference, i, report.size, kChannels[k], neighbours);
+            if (isCaustic(expected, neighbours, count)) {
+                float saturated = std::min(std::fabs(expected), 65504.0f);
+                report.causticValues++;
+                if (!(std::fabs(actual - std::copysign(saturated, expected)) <= kMarschnerCausticTolerance * saturated))
+                    report.causticMismatches++;
+                continue;
+            }
+            bool finite = std::isfinite(expected) && std::isfinite(actual);
+            if (finite) report.values++;
+            if (closeEnough(expected, actual, report.tolerance)) {
+                if (finite)
+                    report.maxError = std::max(report.maxError, std::fabs(actual - expected) / std::max(1.0f, std::fabs(expected)));
+                continue;
+            }
+            if (withinNeighbours(expected, actual, neighbours, count, report.tolerance))
+                report.neighbourMatches++;
+            else if (finite)
+                report.mismatches++;
+            else
+                report.nanMismatches++;
+        }
+    }
+    return report;
+}
+
+}
+
+future<MarschnerComputeReport> MarschnerLUTCompute::validate(int size, const MarschnerParams& params, float tolerance) {
+    MarschnerComputeReport report;
+    report.size = size;
+    report.tolerance = tolerance;
+    if (!available()) return async(launch::deferred, [report] { return report; });
+
+    GLuint textures[kTextures] = {};
+    for (int k = 0; k < kTextures; ++k)
+        allocate(textures[k], size, k);
+
+    // llvmpipe는 GL_TIME_ELAPSED가 0이라 glFinish까지의 시간을 잰다
+    glFinish();
+    auto start = chrono::steady_clock::now();
+    dispatch(textures, size, params);
+    glFinish();
+    report.gpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    vector<vector<uint16_t>> gpu(kTextures);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int k = 0; k < kTextures; ++k) {
+        gpu[k].resize(lutFloatCount(size, kChannels[k]));
+        glBindTexture(GL_TEXTURE_2D, textures[k]);
+        glGetTexImage(GL_TEXTURE_2D, 0, kFormats[k], GL_HALF_FLOAT, gpu[k].data());
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(kTextures, textures);
+
+    return async(launch::async, compareWithReference, report, params, std::move(gpu));
+}
+
+void MarschnerLUTCompute::release() {
+    if (program) glDeleteProgram(program);
+    program = 0;
+}
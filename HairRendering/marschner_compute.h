@@ -0,0 +1,69 @@
+﻿#ifndef MARSCHNER_COMPUTE_H
+#define MARSCHNER_COMPUTE_H
+
+#include <GL/glew.h>
+#include <future>
+#include "marschner_lut.h"
+
+// GPU LUT와 CPU 기준값 비교 허용치: 상대 오차 (|기준| < 1이면 절대 오차)
+const float kMarschnerComputeTolerance = 1e-2f;
+
+// 기준값이 이보다 크면 caustic texel로 본다. 1/|dphi/dh|가 발산해 float 오차가 불어나고 (TT는 8%,
+// A_TRT는 봉우리가 수천을 넘으면 40%까지), half로 바꿀 때 CPU는 inf, GPU는 65504 근처로 포화하므로
+// inf는 65504로 놓고 느슨한 허용치로 비교한다.
+const float kMarschnerCausticAmplitude = 64.0f;
+const float kMarschnerCausticTolerance = 0.5f;
+// 이웃 texel보다 이 배수 이상 큰 값 (|기준| >= 1)도 caustic 봉우리로 본다
+const float kMarschnerCausticPeakRatio = 2.0f;
+
+struct MarschnerComputeReport {
+    int size = 0;
+    double gpuMs = 0.0;             // dispatch부터 glFinish까지
+    double cpuMs = 0.0;             // buildMarschnerLUTs
+    size_t values = 0;              // 허용치로 비교한 채널 값 수 (CPU 쪽이 유한하고 caustic이 아닌 것)
+    size_t mismatches = 0;          // 허용치 밖
+    size_t nanMismatches = 0;       // 한쪽만 NaN/Inf
+    size_t neighbourMatches = 0;    // 허용치 밖이지만 이웃 texel 기준값과 맞거나 그 사이 (caustic 옆 근 선택 경계)
+    size_t causticValues = 0;       // caustic texel 값 수
+    size_t causticMismatches = 0;   // kMarschnerCausticTolerance 밖이거나 GPU 쪽이 NaN
+    float maxError = 0.0f;          // 허용치 안 값들 중 최대 오차
+    float tolerance = kMarschnerComputeTolerance;
+
+    bool passed() const { return mismatches == 0 && nanMismatches == 0 && causticMismatches == 0; }
+};
+
+// marschner_lut.comp로 LUT 여섯 장 (M, NR, NTT, NTRT, packed N과 L_TRT)을 GPU에서 만든다 (GL 4.3+).
+// 파라미터를 바꿀 때 CPU 계산과 PBO 업로드 없이 전역 LUT texture에 바로 쓴다.
+class MarschnerLUTCompute {
+public:
+    MarschnerLUTCompute() = default;
+    MarschnerLUTCompute(const MarschnerLUTCompute&) = delete;
+    MarschnerLUTCompute& operator=(const MarschnerLUTCompute&) = delete;
+
+    // compute shader를 쓸 수 없으면 false (호출자는 CPU 경로를 쓴다)
+    bool init(const char* computeShaderPath);
+    bool available() const { return program != 0; }
+
+    // marschnerTex, NR_tex, NTT_tex, NTRT_tex, N_tex, NL_tex에 쓴다. 크기가 다르면 다시 잡는다.
+    void build(int size, const MarschnerParams& params);
+
+    // 임시 texture에 만들어 buildMarschnerLUTs 결과 (half)와 비교한다. GPU dispatch와 readback은 여기서 기다리고,
+    // CPU 기준값 계산과 비교는 worker thread에서 돌아 future로 돌려준다.
+    std::future<MarschnerComputeReport> validate(int size, const MarschnerParams& params,
+                                                 float tolerance = kMarschnerComputeTolerance);
+
+    void release();
+
+private:
+    static const int kTextures = 6;
+
+    void dispatch(const GLuint textures[kTextures], int size, const MarschnerParams& params);
+
+    GLuint program = 0;
+    GLint sizeLoc = -1;
+    GLint etaLoc = -1;
+    GLint alphaLoc = -1;
+    GLint betaLoc = -1;
+};
+
+#endif
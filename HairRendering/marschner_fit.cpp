@@ -0,0 +1,185 @@
+﻿#include "marschner_fit.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+using namespace std;
+using namespace glm;
+
+namespace {
+
+int segmentOf(float cosThetaD) { return cosThetaD < 0.0f ? 0 : 1; }
+
+// 구간을 [-1, 1]로 옮긴다
+float segmentCoordinate(float cosThetaD) { return cosThetaD < 0.0f ? 2.0f * cosThetaD + 1.0f : 2.0f * cosThetaD - 1.0f; }
+
+void chebyshev(float x, int terms, double* T) {
+    T[0] = 1.0;
+    if (terms > 1) T[1] = x;
+    for (int k = 2; k < terms; ++k) T[k] = 2.0 * x * T[k - 1] - T[k - 2];
+}
+
+// LUT 경로에서 셰이더가 보는 값. NaN은 clamp에서 0이 된다.
+// L이 NaN인 texel은 A도 NaN(= 0)이라 L 값이 결과에 영향이 없으므로 0으로 둔다.
+struct NSample {
+    float NR, ATT, ATRT, LTT, LTRT;
+};
+
+NSample lutSample(const vector<float>& NR, const vector<float>& NTT, const vector<float>& NTRT, size_t t) {
+    NSample s;
+    s.NR = std::isnan(NR[t]) ? 0.0f : std::min(std::max(NR[t], 0.0f), 1.0f);
+    s.ATT = std::isnan(NTT[t * 2]) ? 0.0f : NTT[t * 2];
+    s.ATRT = std::isnan(NTRT[t * 2]) ? 0.0f : NTRT[t * 2];
+    s.LTT = std::isnan(NTT[t * 2 + 1]) ? 0.0f : NTT[t * 2 + 1];
+    s.LTRT = std::isnan(NTRT[t * 2 + 1]) ? 0.0f : NTRT[t * 2 + 1];
+    return s;
+}
+
+void computeN(int size, const MarschnerParams& params, vector<float>& NR, vector<float>& NTT, vector<float>& NTRT) {
+    NR.resize(lutFloatCount(size, kLUTChannelsNR));
+    NTT.resize(lutFloatCount(size, kLUTChannelsNTT));
+    NTRT.resize(lutFloatCount(size, kLUTChannelsNTRT));
+    computeNR_LUT(size, params, NR.data());
+    computeNTT_LUT(size, params, NTT.data());
+    computeNTRT_LUT(size, params, NTRT.data());
+}
+
+// A x = b (대칭 양의 정부호, Cholesky)
+void solveNormal(vector<double>& A, vector<double>& b, int n) {
+    for (int j = 0; j < n; ++j) {
+        double d = A[j * n + j];
+        for (int k = 0; k < j; ++k) d -= A[j * n + k] * A[j * n + k];
+        d = sqrt(std::max(d, 1e-300));
+        A[j * n + j] = d;
+        for (int i = j + 1; i < n; ++i) {
+            double s = A[i * n + j];
+            for (int k = 0; k < j; ++k) s -= A[i * n + k] * A[j * n + k];
+            A[i * n + j] = s / d;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        double s = b[i];
+        for (int k = 0; k < i; ++k) s -= A[i * n + k] * b[k];
+        b[i] = s / A[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double s = b[i];
+        for (int k = i + 1; k < n; ++k) s -= A[k * n + i] * b[k];
+        b[i] = s / A[i * n + i];
+    }
+}
+
+}
+
+MarschnerFit fitMarschnerN(const MarschnerParams& params) {
+    auto start = chrono::steady_clock::now();
+    MarschnerFit fit;
+    fit.params = params;
+
+    const int n = kFitSamples;
+    vector<float> NR, NTT, NTRT;
+    computeN(n, params, NR, NTT, NTRT);
+
+    // 다섯 채널이 같은 basis를 쓰므로 normal matrix는 하나
+    const int channels = 5;
+    for (int segment = 0; segment < kFitSegments; ++segment) {
+        vector<double> AtA(kFitTerms * kFitTerms, 0.0);
+        vector<double> rhs[channels];
+        for (auto& r : rhs) r.assign(kFitTerms, 0.0);
+
+        double Tt[kFitThetaTerms], Tp[kFitPhiTerms], basis[kFitTerms];
+        for (int i = 0; i < n; ++i) {
+            float cosThetaD = -1.0f + 2.0f * (float)i / (n - 1);
+            if (segmentOf(cosThetaD) != segment) continue;
+            chebyshev(segmentCoordinate(cosThetaD), kFitThetaTerms, Tt);
+
+            for (int j = 0; j < n; ++j) {
+                float cosPhiD = -1.0f + 2.0f * (float)j / (n - 1);
+                chebyshev(cosPhiD, kFitPhiTerms, Tp);
+                for (int a = 0; a < kFitThetaTerms; ++a)
+                    for (int b = 0; b < kFitPhiTerms; ++b)
+                        basis[a * kFitPhiTerms + b] = Tt[a] * Tp[b];
+
+                NSample s = lutSample(NR, NTT, NTRT, size_t(j) * n + i);
+                double target[channels] = { s.NR, log1p(double(s.ATT)), log1p(double(s.ATRT)), s.LTT, s.LTRT };
+                for (int r = 0; r < kFitTerms; ++r) {
+                    for (int c = 0; c < kFitTerms; ++c)
+                        AtA[r * kFitTerms + c] += basis[r] * basis[c];
+                    for (int ch = 0; ch < channels; ++ch) rhs[ch][r] += basis[r] * target[ch];
+                }
+            }
+        }
+
+        for (int ch = 0; ch < channels; ++ch) {
+            vector<double> M = AtA;
+            solveNormal(M, rhs[ch], kFitTerms);
+            for (int k = 0; k < kFitTerms; ++k) {
+                int index = segment * kFitTerms + k;
+                if (ch < 4) fit.coefficients[index][ch] = float(rhs[ch][k]);
+                else fit.trtPathCoefficients[index / 4][index % 4] = float(rhs[ch][k]);
+            }
+        }
+    }
+
+    fit.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return fit;
+}
+
+vec4 evaluateMarschnerFit(const MarschnerFit& fit, float cosThetaD, float cosPhiD, float& trtPath) {
+    double Tt[kFitThetaTerms], Tp[kFitPhiTerms];
+    chebyshev(segmentCoordinate(cosThetaD), kFitThetaTerms, Tt);
+    chebyshev(cosPhiD, kFitPhiTerms, Tp);
+    int base = segmentOf(cosThetaD) * kFitTerms;
+    const vec4* c = fit.coefficients + base;
+
+    vec4 sum(0.0f);
+    trtPath = 0.0f;
+    for (int a = 0; a < kFitThetaTerms; ++a)
+        for (int b = 0; b < kFitPhiTerms; ++b) {
+            int k = base + a * kFitPhiTerms + b;
+            float T = float(Tt[a] * Tp[b]);
+            sum += c[a * kFitPhiTerms + b] * T;
+            trtPath += fit.trtPathCoefficients[k / 4][k % 4] * T;
+        }
+    return sum;
+}
+
+MarschnerFitError measureMarschnerFitError(const MarschnerFit& fit, const MarschnerParams& params, int size, const vec3& absorption) {
+    vector<float> NR, NTT, NTRT;
+    computeN(size, params, NR, NTT, NTRT);
+
+    MarschnerFitError error;
+    double sumNR = 0.0, sumTT = 0.0, sumTRT = 0.0;
+    size_t count = 0;
+    auto attenuate = [](float A, float L, vec3 sigma) {
+        return clamp(A * exp(-sigma * L), vec3(0.0f), vec3(1.0f));
+    };
+
+    for (int i = 0; i < size; ++i) {
+        float cosThetaD = -1.0f + 2.0f * (float)i / (size - 1);
+        for (int j = 0; j < size; ++j) {
+            float cosPhiD = -1.0f + 2.0f * (float)j / (size - 1);
+            NSample s = lutSample(NR, NTT, NTRT, size_t(j) * size + i);
+            float trtPath;
+            vec4 f = evaluateMarschnerFit(fit, cosThetaD, cosPhiD, trtPath);
+
+            float eNR = fabs(std::min(std::max(f.x, 0.0f), 1.0f) - s.NR);
+            vec3 eTT = abs(attenuate(expm1f(f.y), f.w, absorption) - attenuate(s.ATT, s.LTT, absorption));
+            vec3 eTRT = abs(attenuate(expm1f(f.z), trtPath, 2.0f * absorption) - attenuate(s.ATRT, s.LTRT, 2.0f * absorption));
+
+            float mTT = std::max(eTT.x, std::max(eTT.y, eTT.z));
+            float mTRT = std::max(eTRT.x, std::max(eTRT.y, eTRT.z));
+            sumNR += double(eNR) * eNR;
+            sumTT += double(dot(eTT, eTT)) / 3.0;
+            sumTRT += double(dot(eTRT, eTRT)) / 3.0;
+            error.maxNR = std::max(error.maxNR, eNR);
+            error.maxTT = std::max(error.maxTT, mTT);
+            error.maxTRT = std::max(error.maxTRT, mTRT);
+            ++count;
+        }
+    }
+    error.rmsNR = float(sqrt(sumNR / count));
+    error.rmsTT = float(sqrt(sumTT / count));
+    error.rmsTRT = float(sqrt(sumTRT / count));
+    return error;
+}
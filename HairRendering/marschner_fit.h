@@ -0,0 +1,40 @@
+﻿#ifndef MARSCHNER_FIT_H
+#define MARSCHNER_FIT_H
+
+#include "marschner_lut.h"
+#include <glm/glm.hpp>
+
+// N LUT를 대신하는 근사식 (texture 없이 셰이더에서 계산).
+// cos(theta_d) < 0 / >= 0 두 구간에서 따로 (theta, phi) Chebyshev 다항식으로 fit한다.
+// cos(theta_d) = 0에서 eta'의 부호가 바뀌어 TT/TRT 근 (과 근이 없어 NaN, 셰이더에서 0인 곳)이 끊기기 때문이다.
+// 채널: (clamp(N_R, 0, 1), log(1 + A_TT), log(1 + A_TRT), L_TT)와 L_TRT. A는 caustic 근처에서 1e4까지 튀므로 log로 fit한다.
+// hair_shader.frag의 FIT_THETA_TERMS / FIT_PHI_TERMS와 같아야 한다.
+const int kFitThetaTerms = 6;
+const int kFitPhiTerms = 8;
+const int kFitTerms = kFitThetaTerms * kFitPhiTerms;
+const int kFitSegments = 2;
+const int kFitSamples = 128;    // 구간마다 fit할 때 쓰는 LUT 크기
+
+struct MarschnerFit {
+    glm::vec4 coefficients[kFitSegments * kFitTerms];   // [segment][theta][phi]
+    // L_TRT (TRT는 p = 2 근이라 L_TT와 다르다). 계수 k는 [k / 4][k % 4]에 넣어 uniform vec4 배열로 올린다
+    glm::vec4 trtPathCoefficients[kFitSegments * kFitTerms / 4];
+    MarschnerParams params;         // fit에 쓴 값. 셰이더의 M lobe도 이 값을 써야 N과 맞는다
+    double milliseconds = 0.0;
+};
+
+MarschnerFit fitMarschnerN(const MarschnerParams& params);
+
+// 셰이더의 fittedN과 같은 식. L_TRT는 trtPath에 쓴다
+glm::vec4 evaluateMarschnerFit(const MarschnerFit& fit, float cosThetaD, float cosPhiD, float& trtPath);
+
+// 셰이더가 실제로 쓰는 값 (clamp, 흡수 적용 후)으로 LUT 경로와 비교
+struct MarschnerFitError {
+    float rmsNR = 0.0f, maxNR = 0.0f;
+    float rmsTT = 0.0f, maxTT = 0.0f;
+    float rmsTRT = 0.0f, maxTRT = 0.0f;
+};
+
+MarschnerFitError measureMarschnerFitError(const MarschnerFit& fit, const MarschnerParams& params, int size, const glm::vec3& absorption);
+
+#endif
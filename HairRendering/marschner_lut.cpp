@@ -0,0 +1,377 @@
+﻿#include "marschner_lut.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <vector>
+#include "marschner_batch.h"
+#include "thread_pool.h"
+using namespace std;
+using namespace glm;
+
+// constants
+const float PI = 3.141592653589793238;
+
+// LUT는 바깥 루프(i) 몇 줄씩 묶은 tile 단위로 thread pool에 나눈다.
+// 각 texel은 독립적이므로 결과는 스레드 수와 관계없이 같다.
+const size_t kLUTRowTile = 8;
+
+static void forEachLUTRow(int size, unsigned maxThreads, const function<void(int)>& row) {
+    ThreadPool::global().parallelFor(size_t(size), kLUTRowTile, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) row(int(i));
+    }, maxThreads);
+}
+
+MarschnerParams MarschnerParams::withShift(float alphaR, float betaR) {
+    MarschnerParams params;
+    params.alphaR = alphaR;
+    params.alphaTT = -alphaR / 2.0;
+    params.alphaTRT = -3.0 * alphaR / 2.0;
+    params.betaR = betaR;
+    params.betaTT = betaR / 2.0;
+    params.betaTRT = 2.0 * betaR;
+    return params;
+}
+
+float computeEtaPrime(float eta, float thetaD) {
+    float sinPowThetaD = sin(thetaD) * sin(thetaD);
+    float etaPrime = (sqrt(eta * eta - sinPowThetaD)) / cos(thetaD);
+    return etaPrime;
+}
+
+float computeEtaDoublePrime(float eta, float thetaD) {
+    float sinPowThetaD = sin(thetaD) * sin(thetaD);
+    float etaDoublePrime = eta * eta * cos(thetaD) / sqrt(eta * eta - sinPowThetaD);
+    return etaDoublePrime;
+}
+
+// 섬유 안을 지나는 거리. T = exp(-2 * sigma_a' * (1 + cos(2 gamma_t))) = exp(-absorption * L)
+float absorptionPathLength(float theta_t, float gamma_t) {
+    float cosThetaT = cos(theta_t);
+    return 2.0f * (1.0f + cos(2.0f * gamma_t)) / cosThetaT;
+}
+
+// highlight shift 적용 Gaussian
+float marschner_M(float theta_i, float theta_o, float beta, float alpha) {     
+    float theta_h = (theta_i + theta_o) / 2.0f;
+    float shifted_theta_h = theta_h - alpha;
+
+    float normalization = 1.0 / sqrt(2.0 * PI * beta * beta);
+    return normalization * exp(-pow(shifted_theta_h, 2) / (2.0 * beta * beta));
+}
+
+// Longitudinal scattering texture
+void computeM_LUT(int size, const MarschnerParams& params, float* textureData, unsigned maxThreads) {
+
+    forEachLUTRow(size, maxThreads, [&](int i) {
+        float sin_theta_i = -1.0f + 2.0f * (float)i / (size - 1);
+		float theta_i = asinf(sin_theta_i); 
+
+        for (int j = 0; j < size; j++) {
+            float sin_theta_o = -1.0f + 2.0f * (float)j / (size - 1);
+            float theta_o = asinf(sin_theta_o);
+			float cosThetaD = cos((theta_o -theta_i) / 2);
+
+            float M_R = marschner_M(theta_i, theta_o, params.betaR, params.alphaR);
+            float M_TT = marschner_M(theta_i, theta_o, params.betaTT, params.alphaTT);
+            float M_TRT = marschner_M(theta_i, theta_o, params.betaTRT, params.alphaTRT);
+
+            int index = (j * size + i) * 4;
+            textureData[index] = M_R;    // R
+            textureData[index + 1] = M_TT; // G
+            textureData[index + 2] = M_TRT; // B
+            textureData[index + 3] = cosThetaD; // A
+        }
+    });
+}
+
+
+float gaussian(float x, float wc) {
+    float norm = 1.0f / (wc * sqrt(2.0f * PI));
+    return norm * exp(-(x * x) / (2.0f * wc * wc));
+}
+
+
+// Fresnel 반사율 계산
+float FresnelReflectance(float gamma_i, float etaPrime, float etaDoublePrime) {
+    complex<float> eta(etaPrime, etaDoublePrime); 
+    complex<float> cosThetaI(gamma_i, 0.0f);
+
+    // Snell's law
+    complex<float> sinThetaI = sqrt(1.0f - cosThetaI * cosThetaI);
+    complex<float> sinThetaT = sinThetaI / eta;
+    complex<float> cosThetaT = sqrt(1.0f - (sinThetaT * sinThetaT));
+
+    // Fresnel 반사율 계산
+    complex<float> Rs = (eta * cosThetaI - cosThetaT) / (eta * cosThetaI + cosThetaT);
+    complex<float> Rp = (cosThetaI - eta * cosThetaT) / (cosThetaI + eta * cosThetaT);
+
+    float F = 0.5f * (std::norm(Rs) + std::norm(Rp)); // norm()은 복소수의 절댓값 제곱
+    return F;
+}
+
+const float pi = 3.14159265358979323846f;
+
+float solveGammaT(float c, float gamma_i) {
+    float a = (3 * c / PI) * gamma_i;
+    float b = (4 * c / PI * PI * PI) * gamma_i * gamma_i * gamma_i;
+    return a - b;
+}
+
+float dphidh(int p, float c, float gamma_i, float h) {
+    float a = ((6.0f * p * c / PI) - 2.0f) - (3.0f * 8.0f * p * c / (PI * PI * PI) * gamma_i * gamma_i);
+    float b = sqrt(1.0f - h * h);
+    return a / b;
+}
+
+// phi는 2pi 주기라 p pi 대신 (p pi) mod 2pi를 더한다.
+// p = 2 (TRT)에서 2pi를 그대로 두면 phi_d - 2pi가 |gamma_i| <= pi/2 안에서 닿지 않아 엉뚱한 근만 남는다.
+float evaluate_phi_hat(int p, float gamma_i, float c) {
+    float term1 = ((6.0f * p * c) / pi - 2.0f) * gamma_i;
+    float term2 = (8.0f * p * c) / (pi * pi * pi) * pow(gamma_i, 3.0f);
+    return term1 - term2 + (p % 2) * pi;
+}
+
+vector<complex<float>> solveCubic(float a, float b, float c) {
+    using cf = complex<float>;
+
+    if (fabs(a) < 1e-6f) {
+        if (fabs(b) < 1e-6f) return {}; 
+        return { cf(-c / b, 0.0f) };
+    }
+
+    float p = b / a;
+    float q = c / a;
+    float delta = pow(q / 2.0f, 2) + pow(p / 3.0f, 3);
+
+    // u v = -p/3이어야 x1 = u + v가 근이다. delta >= 0이면 u^3, v^3이 실수라 실수 세제곱근을 쓴다
+    // (음수의 주값 세제곱근을 쓰면 u v가 복소수가 되어 실근을 놓친다).
+    // 절댓값이 큰 쪽 v^3 = -q/2 - sign(q) sqrt(delta)만 계산하고 u = -p / (3v)로 얻어 상쇄 오차를 피한다.
+    // delta < 0이면 u^3, v^3이 켤레라 주값끼리도 켤레가 되어 그대로 맞는다.
+    cf u, v;
+    if (delta >= 0.0f) {
+        float w = cbrt(-q / 2.0f - copysign(sqrt(delta), q));
+        u = cf(w != 0.0f ? -p / (3.0f * w) : 0.0f, 0.0f);
+        v = cf(w, 0.0f);
+    }
+    else {
+        cf sqrt_delta = sqrt(cf(delta, 0.0f));
+        u = pow(-q / 2.0f + sqrt_delta, 1.0f / 3.0f);
+        v = pow(-q / 2.0f - sqrt_delta, 1.0f / 3.0f);
+    }
+
+    cf omega1(-0.5f, sqrt(3) / 2.0f);
+    cf omega2(-0.5f, -sqrt(3) / 2.0f);
+
+    cf x1 = u + v;
+    cf x2 = u * omega1 + v * omega2;
+    cf x3 = u * omega2 + v * omega1;
+
+    return { x1, x2, x3 };
+}
+
+// a x^3 + b x + cc = 0의 근 x를 Newton 한 번으로 다듬는다 (kMaxRootPolish)
+static float polishRoot(float a, float b, float cc, float x) {
+    float step = (a * x * x * x + b * x + cc) / (3.0f * a * x * x + b);
+    return fabs(step) < kMaxRootPolish ? x - step : x;
+}
+
+float solveGammaI(float phi_d, int p, float c) {
+    float a = (8.0f * p * c) / pow(pi, 3.0f);
+    float b = -((6.0f * p * c) / pi - 2.0f);
+    float cc = phi_d - (p % 2) * pi;
+
+    auto roots = solveCubic(a, b, cc);
+
+    float best = NAN;
+    float min_err = 1e10f;
+    float min_gamma_magnitude = 100.0f; 
+
+    for (auto& r : roots) {
+        if (fabs(r.imag()) < 1e-2f) { 
+            float realRoot = r.real();
+            if (fabs(realRoot) > kMaxGammaI) continue;
+
+            float phi_hat = evaluate_phi_hat(p, realRoot, c);
+            float err = fabs(phi_hat - phi_d);
+
+            if (p == 2) { 
+                if (err < 0.3f && fabs(realRoot) < min_gamma_magnitude) {
+                    best = realRoot;
+                    min_err = err;
+                    min_gamma_magnitude = fabs(realRoot);
+                }
+            }
+            else {
+                if (err < min_err) {
+                    best = realRoot;
+                    min_err = err;
+                }
+            }
+        }
+    }
+    
+    return polishRoot(a, b, cc, best);
+}
+
+
+/*
+float phi_p(float gamma_i, int p, float c) {
+    float a = (6.0f * p * c / PI) - 2.0f;
+    float b = -8.0f * p * c / (PI * PI * PI);
+    return a * gamma_i + b * gamma_i * gamma_i * gamma_i + p * PI;
+}
+*/
+
+/* 이분
+float solveGammaI(float phi_d, int p, float eta, float c) {
+    float lower = -c;
+    float upper = c;
+    float mid;
+    float epsilon = 1e-4f;
+    int max_iter = 50;
+
+    for (int i = 0; i < max_iter; ++i) { 
+        mid = 0.5f * (lower + upper);
+        float phi_mid = phi_p(mid, p, c);
+        float f_mid = phi_mid - phi_d;
+
+        if (fabs(f_mid) < epsilon)
+            return mid;
+
+        float phi_lower = phi_p(lower, p, c);
+        float f_lower = phi_lower - phi_d;
+
+        if (f_mid * f_lower < 0)
+            upper = mid;
+        else
+            lower = mid;
+    }
+
+    return mid; 
+}
+*/
+
+// N_* LUT의 j축 (phi_d). 모든 줄이 같은 값을 쓴다.
+static vector<float> lutPhiD(int size) {
+    vector<float> phi_d(size);
+    for (int j = 0; j < size; j++) {
+        float cos_phi_d = -1.0f + 2.0f * (float)j / (size - 1);
+        phi_d[j] = acosf(cos_phi_d);
+    }
+    return phi_d;
+}
+
+// N_* LUT는 줄(theta_d)마다 phi_d 전체를 batch 커널로 풀고 나머지만 texel별로 계산한다
+void computeNR_LUT(int size, const MarschnerParams& params, float* textureData, unsigned maxThreads) {
+    float eta = params.eta;
+    vector<float> phi_d = lutPhiD(size);
+
+    forEachLUTRow(size, maxThreads, [&](int i) {
+        float cos_theta_d = -1.0f + 2.0f * (float)i / (size - 1);
+        float theta_d = acosf(cos_theta_d); 
+        float etaPrime = computeEtaPrime(eta, theta_d);
+        float etaDoublePrime = computeEtaDoublePrime(eta, theta_d);
+        float c = asinf(1.0f / etaPrime);
+
+        vector<float> gamma_i(size), F(size);
+        solveGammaIBatch(phi_d.data(), size, 0, c, gamma_i.data());
+        fresnelReflectanceBatch(gamma_i.data(), size, etaPrime, etaDoublePrime, F.data());
+
+        for (int j = 0; j < size; j++) {
+            float N_R = F[j];
+            int index = j * size + i;
+            textureData[index] = N_R;
+        }
+    });
+}
+
+
+void computeNTT_LUT(int size, const MarschnerParams& params, float* textureData, unsigned maxThreads) {
+    float eta = params.eta;
+    vector<float> phi_d = lutPhiD(size);
+
+    forEachLUTRow(size, maxThreads, [&](int i) {
+        float cos_theta_d = -1.0f + 2.0f * (float)i / (size - 1);
+		float theta_d = acosf(cos_theta_d); 
+        float theta_t = asin(sin(theta_d) / eta); 
+
+        float etaPrime = computeEtaPrime(eta, theta_d);
+        float etaDoublePrime = computeEtaDoublePrime(eta, theta_d);
+        float c = asin(1.0f / etaPrime);
+
+        vector<float> gamma_i(size), F(size);
+        solveGammaIBatch(phi_d.data(), size, 1, c, gamma_i.data());
+        fresnelReflectanceBatch(gamma_i.data(), size, etaPrime, etaDoublePrime, F.data());
+
+        for (int j = 0; j < size; j++) {
+            float h = sinf(gamma_i[j]);
+			float gamma_t = asinf(h / etaPrime); 
+
+            float L = absorptionPathLength(theta_t, gamma_t);
+            float N_R = F[j];
+            
+            float inverse_double_dphidh = 1.0f / fabs(2.0f * dphidh(1, c, gamma_i[j], h));
+            float A_TT = pow(1.0f - N_R, 2.0f) * inverse_double_dphidh;
+
+            int index = (j * size + i) * 2;
+			textureData[index] = A_TT;
+			textureData[index + 1] = L;
+        }
+    });
+}
+
+
+void computeNTRT_LUT(int size, const MarschnerParams& params, float* textureData, unsigned maxThreads) {
+    float eta = params.eta;
+    vector<float> phi_d = lutPhiD(size);
+
+    forEachLUTRow(size, maxThreads, [&](int i) {
+        float cos_theta_d = -1.0f + 2.0f * (float)i / (size - 1);
+		float theta_d = acosf(cos_theta_d); 
+        float theta_t = asin(sin(theta_d) / eta);// snell's law
+
+        float etaPrime = computeEtaPrime(eta, theta_d);
+        float etaDoublePrime = computeEtaDoublePrime(eta, theta_d);
+        float c = asinf((1 / etaPrime));
+
+        // TRT는 TT와 다른 근 (p = 2)이라 gamma_t와 L도 따로 나온다
+        vector<float> gamma_i(size), gamma_t(size), F(size), F_t(size);
+        solveGammaIBatch(phi_d.data(), size, 2, c, gamma_i.data());
+        for (int j = 0; j < size; j++)
+            gamma_t[j] = asinf(sinf(gamma_i[j]) / etaPrime);
+        fresnelReflectanceBatch(gamma_i.data(), size, etaPrime, etaDoublePrime, F.data());
+        fresnelReflectanceBatch(gamma_t.data(), size, 1.0f / etaPrime, 1.0f / etaDoublePrime, F_t.data());
+
+        for (int j = 0; j < size; j++) {
+            float h = sinf(gamma_i[j]);
+
+            float L = absorptionPathLength(theta_t, gamma_t[j]);
+
+            float N_R = F[j];
+            float inverse_double_dphidh = 1.0f / fabs(2.0f * dphidh(2, c, gamma_i[j], h));
+            float A_TRT = pow(1.0f - N_R, 2.0f) * F_t[j] * inverse_double_dphidh;
+
+            int index = (j * size + i) * 2;
+
+			textureData[index] = A_TRT;
+			textureData[index + 1] = L;
+        }
+    });
+}
+
+LUTTimings timeLUTGeneration(int size, unsigned threads, const MarschnerParams& params) {
+    LUTTimings timings;
+    vector<float> data(lutFloatCount(size, kLUTChannelsM));
+    auto time = [](const function<void()>& fn) {
+        auto start = chrono::steady_clock::now();
+        fn();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    timings.M = time([&] { computeM_LUT(size, params, data.data(), threads); });
+    timings.NR = time([&] { computeNR_LUT(size, params, data.data(), threads); });
+    timings.NTT = time([&] { computeNTT_LUT(size, params, data.data(), threads); });
+    timings.NTRT = time([&] { computeNTRT_LUT(size, params, data.data(), threads); });
+    return timings;
+}
@@ -0,0 +1,73 @@
+﻿#ifndef MARSCHNER_LUT_H
+#define MARSCHNER_LUT_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// GL 없이 Marschner LUT만 계산하는 API.
+// 결과는 호출자가 준 float 버퍼에 texture 업로드 배치 그대로 채운다:
+//   index = (j * size + i) * channels
+//   M:          i = sin(theta_i), j = sin(theta_o)   (R, TT, TRT, cos(theta_d))
+//   N_R/TT/TRT: i = cos(theta_d), j = cos(phi_d)
+// N_TT/N_TRT는 흡수를 빼고 (A, L) 두 채널로 둔다. TT는 p = 1, TRT는 p = 2 근에서 계산하므로 L이 다르다.
+// 셰이더가 absorption을 곱한다:
+//   N_TT = A_TT * exp(-absorption * L),  N_TRT = A_TRT * exp(-2 * absorption * L)
+// 그래서 머리색이 바뀌어도 LUT는 그대로다.
+// 각 함수는 thread pool을 쓰며 maxThreads가 0이면 pool 전체를 쓴다.
+const int kLUTChannelsM = 4;
+const int kLUTChannelsNR = 1;
+const int kLUTChannelsNTT = 2;
+const int kLUTChannelsNTRT = 2;
+
+inline size_t lutFloatCount(int size, int channels) { return size_t(size) * size_t(size) * size_t(channels); }
+
+// Fiber / surface 파라미터. 기본값은 기존 상수와 같다.
+struct MarschnerParams {
+    float eta = 1.55f;
+
+    // longitudinal shift (alpha)와 width (beta), radian
+    float alphaR = -glm::radians(7.5);
+    float alphaTT = -alphaR / 2.0;
+    float alphaTRT = -3.0 * alphaR / 2.0;
+    float betaR = glm::radians(7.5);
+    float betaTT = betaR / 2.0;
+    float betaTRT = 2.0 * betaR;
+
+    // R lobe 값에서 TT/TRT를 Marschner 논문 비율로 유도
+    static MarschnerParams withShift(float alphaR, float betaR);
+};
+
+float marschner_M(float theta_i, float theta_o, float beta, float alpha);
+
+// 스칼라 기준 구현. LUT는 marschner_batch.h의 batch 커널로 만들고, 이쪽은 검증에 쓴다.
+float computeEtaPrime(float eta, float thetaD);
+float computeEtaDoublePrime(float eta, float thetaD);
+float FresnelReflectance(float gamma_i, float etaPrime, float etaDoublePrime);
+float solveGammaI(float phi_d, int p, float c);
+
+// gamma_i = asin(h)라 |gamma_i|가 pi/2를 넘는 근은 버린다.
+// p = 0, phi_d = pi의 근이 정확히 -pi/2라서 float 오차로 떨어지지 않게 조금 여유를 둔다.
+const float kMaxGammaI = 1.5707963f + 1e-3f;
+
+// 고른 근은 Newton 한 번으로 다듬는다. 근 공식의 반올림 오차가 caustic 옆 (겹근 근처)에서 커지기 때문이다.
+// 미분도 0에 가까운 caustic 위에서는 step이 발산하므로 이보다 크면 다듬지 않는다.
+const float kMaxRootPolish = 1e-3f;
+
+void computeM_LUT(int size, const MarschnerParams& params, float* out, unsigned maxThreads = 0);
+void computeNR_LUT(int size, const MarschnerParams& params, float* out, unsigned maxThreads = 0);
+void computeNTT_LUT(int size, const MarschnerParams& params, float* out, unsigned maxThreads = 0);
+void computeNTRT_LUT(int size, const MarschnerParams& params, float* out, unsigned maxThreads = 0);
+
+// 네 LUT의 CPU 계산 시간 (ms, GL 업로드 제외). threads가 0이면 thread pool 전체를 쓴다.
+struct LUTTimings {
+    double M = 0.0;
+    double NR = 0.0;
+    double NTT = 0.0;
+    double NTRT = 0.0;
+
+    double total() const { return M + NR + NTT + NTRT; }
+};
+
+LUTTimings timeLUTGeneration(int size, unsigned threads, const MarschnerParams& params);
+
+#endif
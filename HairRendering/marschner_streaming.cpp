@@ -0,0 +1,166 @@
+﻿#define GLEW_STATIC
+#include "marschner_streaming.h"
+#include "marschner_texture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+namespace {
+
+const GLenum kInternalFormats[kMarschnerLUTCount] = { GL_RGBA16F, GL_R16F, GL_RG16F, GL_RG16F };
+const GLenum kFormats[kMarschnerLUTCount] = { GL_RGBA, GL_RED, GL_RG, GL_RG };
+
+MarschnerLUTData buildLUTs(int size, MarschnerParams params) {
+    MarschnerLUTData data;
+    auto start = chrono::steady_clock::now();
+
+    // 이미 캐시된 값이면 읽기만 한다.
+    // 슬라이더 중간 값마다 .mlut가 쌓이지 않도록 새로 만든 것은 캐시에 쓰지 않는다.
+    uint64_t hash = hashMarschnerParams(params, size);
+    data.fromCache = readMarschnerCache(marschnerCachePath(params, size), hash, size, data);
+    if (!data.fromCache)
+        buildMarschnerLUTs(size, params, data);
+
+    data.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return data;
+}
+
+}
+
+void MarschnerLUTStreamer::request(int size, const MarschnerParams& params) {
+    if (pending.valid()) {
+        hasQueued = true;
+        queuedSize = size;
+        queuedParams = params;
+        return;
+    }
+    start(size, params);
+}
+
+void MarschnerLUTStreamer::start(int size, const MarschnerParams& params) {
+    hasQueued = false;
+    buildRequestTime = chrono::steady_clock::now();
+    pending = async(launch::async, buildLUTs, size, params);
+}
+
+bool MarschnerLUTStreamer::update() {
+    bool swapped = false;
+    if (uploading) {
+        // 업로드가 GPU에서 끝났을 때만 교체한다 (기다리지 않음)
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        finishUpload();
+        swapped = true;
+    }
+
+    // 새 요청이 기다리고 있어도 끝난 결과는 먼저 올린다 (슬라이더를 끄는 동안에도 중간 LUT가 보이도록)
+    if (pending.valid() && pending.wait_for(chrono::seconds(0)) == future_status::ready) {
+        MarschnerLUTData data = pending.get();
+        uploadRequestTime = buildRequestTime;
+        beginUpload(data);
+    }
+    // 다음 계산은 업로드와 겹쳐서 진행한다
+    if (hasQueued && !pending.valid())
+        start(queuedSize, queuedParams);
+    return swapped;
+}
+
+void MarschnerLUTStreamer::beginUpload(const MarschnerLUTData& data) {
+    buildMs = data.milliseconds;
+    fromCache = data.fromCache;
+
+    if (backSize != data.size) {
+        for (int k = 0; k < kMarschnerLUTCount; ++k) {
+            if (back[k]) glDeleteTextures(1, &back[k]);
+            uploadLUT(back[k], data.size, kInternalFormats[k], kFormats[k], nullptr, GL_HALF_FLOAT);
+        }
+        if (backN) glDeleteTextures(1, &backN);
+        if (backNL) glDeleteTextures(1, &backNL);
+        uploadLUT(backN, data.size, GL_RGBA16F, GL_RGBA, nullptr, GL_HALF_FLOAT);
+        uploadLUT(backNL, data.size, GL_R16F, GL_RED, nullptr, GL_HALF_FLOAT);
+        backSize = data.size;
+    }
+
+    // 네 LUT와 packed N을 PBO 하나에 이어 쓰고, texture로의 복사는 드라이버가 비동기로 처리한다
+    size_t bytes = data.halves.size() * sizeof(uint16_t);
+    size_t packedBytes = lutFloatCount(data.size, kLUTChannelsPackedN + kLUTChannelsPackedL) * sizeof(uint16_t);
+    if (!pbo) glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    pboBytes = std::max(pboBytes, bytes + packedBytes);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, pboBytes, nullptr, GL_STREAM_DRAW);
+    uint16_t* mapped = static_cast<uint16_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes + packedBytes,
+                                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (mapped) {
+        memcpy(mapped, data.halves.data(), bytes);
+        packMarschnerN(data, mapped + data.halves.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else {
+        // 매핑이 실패하면 한 번 더 복사해서 glBufferSubData로 올린다
+        cerr << "[LUT] glMapBufferRange failed (0x" << hex << glGetError() << dec << "), uploading with glBufferSubData" << endl;
+        vector<uint16_t> staging(data.halves.size() + packedBytes / sizeof(uint16_t));
+        std::copy(data.halves.begin(), data.halves.end(), staging.begin());
+        packMarschnerN(data, staging.data() + data.halves.size());
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, bytes + packedBytes, staging.data());
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int k = 0; k < kMarschnerLUTCount; ++k) {
+        const void* offset = reinterpret_cast<const void*>(data.offset(k) * sizeof(uint16_t));
+        glBindTexture(GL_TEXTURE_2D, back[k]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, data.size, data.size, kFormats[k], GL_HALF_FLOAT, offset);
+    }
+    size_t packedLOffset = bytes + lutFloatCount(data.size, kLUTChannelsPackedN) * sizeof(uint16_t);
+    glBindTexture(GL_TEXTURE_2D, backN);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, data.size, data.size, GL_RGBA, GL_HALF_FLOAT, reinterpret_cast<const void*>(bytes));
+    glBindTexture(GL_TEXTURE_2D, backNL);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, data.size, data.size, GL_RED, GL_HALF_FLOAT,
+                    reinterpret_cast<const void*>(packedLOffset));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    uploading = true;
+}
+
+void MarschnerLUTStreamer::finishUpload() {
+    glDeleteSync(fence);
+    fence = 0;
+    uploading = false;
+
+    // 이전 front는 다음 요청의 back으로 재사용한다
+    GLuint* front[kMarschnerLUTCount] = { &marschnerTex, &NR_tex, &NTT_tex, &NTRT_tex };
+    for (int k = 0; k < kMarschnerLUTCount; ++k)
+        std::swap(*front[k], back[k]);
+    std::swap(N_tex, backN);
+    std::swap(NL_tex, backNL);
+    std::swap(frontSize, backSize);
+
+    latencyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - uploadRequestTime).count();
+    cout << "[LUT] swapped after " << latencyMs << " ms (" << (fromCache ? "cache" : "build") << " "
+         << buildMs << " ms)" << endl;
+}
+
+void MarschnerLUTStreamer::release() {
+    if (pending.valid()) pending.wait();
+    pending = future<MarschnerLUTData>();
+    hasQueued = false;
+    if (fence) glDeleteSync(fence);
+    fence = 0;
+    uploading = false;
+    glDeleteTextures(kMarschnerLUTCount, back);
+    for (GLuint& texture : back) texture = 0;
+    if (backN) glDeleteTextures(1, &backN);
+    if (backNL) glDeleteTextures(1, &backNL);
+    backN = 0;
+    backNL = 0;
+    backSize = 0;
+    if (pbo) glDeleteBuffers(1, &pbo);
+    pbo = 0;
+    pboBytes = 0;
+}
@@ -0,0 +1,62 @@
+﻿#ifndef MARSCHNER_STREAMING_H
+#define MARSCHNER_STREAMING_H
+
+#include <GL/glew.h>
+#include "marschner_cache.h"
+#include <chrono>
+#include <future>
+
+// 파라미터를 바꿀 때 LUT 계산은 worker thread에서 하고, 결과는 PBO로 back texture에 올린다.
+// 업로드 fence가 끝난 프레임에 marschnerTex/NR_tex/NTT_tex/NTRT_tex를 교체하므로
+// 그동안은 이전 LUT로 계속 그린다.
+// 계산 중에 들어온 요청은 마지막 것만 남겨 두었다가 끝나면 이어서 시작한다 (슬라이더용).
+// 끝난 결과는 버리지 않고 올리며, 다음 계산은 그 업로드와 겹쳐서 한다.
+class MarschnerLUTStreamer {
+public:
+    MarschnerLUTStreamer() = default;
+    MarschnerLUTStreamer(const MarschnerLUTStreamer&) = delete;
+    MarschnerLUTStreamer& operator=(const MarschnerLUTStreamer&) = delete;
+
+    void request(int size, const MarschnerParams& params);
+
+    // 매 프레임 한 번 호출. LUT가 교체된 프레임에 true를 반환한다.
+    bool update();
+
+    bool busy() const { return pending.valid() || uploading || hasQueued; }
+    double lastBuildMs() const { return buildMs; }         // worker에서 계산 (또는 캐시 읽기)
+    double lastLatencyMs() const { return latencyMs; }     // 요청부터 교체까지
+    bool lastFromCache() const { return fromCache; }
+
+    // GL context가 살아 있을 때 호출
+    void release();
+
+private:
+    void start(int size, const MarschnerParams& params);
+    void beginUpload(const MarschnerLUTData& data);
+    void finishUpload();
+
+    std::future<MarschnerLUTData> pending;
+    std::chrono::steady_clock::time_point buildRequestTime;    // 계산 중인 요청
+    std::chrono::steady_clock::time_point uploadRequestTime;   // 올리는 중인 요청
+
+    bool hasQueued = false;
+    int queuedSize = 0;
+    MarschnerParams queuedParams;
+
+    // back LUT. 교체할 때 front(전역 핸들)와 바꾸고 다음 요청에 재사용한다.
+    GLuint back[kMarschnerLUTCount] = {};
+    GLuint backN = 0;       // packed N (N_tex)
+    GLuint backNL = 0;      // packed N의 L_TRT (NL_tex)
+    int backSize = 0;
+    int frontSize = 0;      // 0이면 모름 (처음 올린 LUT)
+    GLuint pbo = 0;
+    size_t pboBytes = 0;
+    GLsync fence = 0;
+    bool uploading = false;
+
+    double buildMs = 0.0;
+    double latencyMs = 0.0;
+    bool fromCache = false;
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include "marschner_lut.h"
+#include "marschner_cache.h"
 
 using namespace glm;
 
@@ -11,15 +13,32 @@ extern GLuint marschnerTex;
 extern GLuint NR_tex;
 extern GLuint NTT_tex;
 extern GLuint NTRT_tex;
+extern GLuint N_tex;        // NR/NTT/NTRT를 합친 RGBA16F (packMarschnerN)
+extern GLuint NL_tex;       // packed N의 L_TRT, R16F
 
-float marschner_M(float cos_theta_i, float cos_theta_o, float beta, float alpha);
+// hair_shader.frag의 M/N 계산 방식. Packed는 M 다음에 한 번만 읽는다.
+enum class MarschnerLUTLayout {
+    Separate,   // NR, NTT, NTRT 세 장
+    Packed,     // N_tex와 L_TRT (NL_tex)
+    Fitted      // texture 없이 M은 직접, N은 근사식으로 (marschner_fit.h)
+};
+
+// GL 업로드 층. 계산은 marschner_lut.h의 GL 없는 API가 맡는다.
+// data는 computeXXX_LUT가 채운 배치 그대로 (size x size, type은 GL_FLOAT 또는 GL_HALF_FLOAT)
+GLuint uploadLUT(GLuint& texture, int size, GLenum internalFormat, GLenum format, const void* data, GLenum type = GL_FLOAT);
+
+// 캐시에서 읽은 (또는 새로 만든) half float LUT 네 장과 packed N (N_tex, NL_tex)을 올린다. 기존 texture는 지운다.
+void uploadMarschnerLUTs(const MarschnerLUTData& data);
+
+GLuint createMarschnerTexture(int size, const MarschnerParams& params);
+GLuint createNR_Texture(int size, const MarschnerParams& params);
+GLuint createNTT_Texture(int size, const MarschnerParams& params);
+GLuint createNTRT_Texture(int size, const MarschnerParams& params);
 
 GLuint createMarschnerTexture(int size);
 GLuint createNR_Texture(int size, float eta);
-GLuint createNTT_Texture(int size, float eta, vec3 absorption);
-GLuint createNTRT_Texture(int size, float eta, vec3 absorption);
-
-float fresnelReflect(float cosPhiD, float F0);
+GLuint createNTT_Texture(int size, float eta);
+GLuint createNTRT_Texture(int size, float eta);
 
 void saveMarschnerTexture(GLuint textureID, int size, const char* filename);
 void saveNR_Texture(GLuint textureID, int size, const char* filename);
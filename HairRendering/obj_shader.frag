@@ -5,8 +5,16 @@ in vec3 Normal;
 
 out vec4 FragColor;
 
-uniform vec3 lightPos; 
-uniform vec3 viewPos;  
+//   (shader_uniforms.h FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer ũ (pixel)
+    float pixelsPerUnit;    // Ÿ 1  1 ϴ pixel 
+};
 uniform float gamma;  
 
 void main()
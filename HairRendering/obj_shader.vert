@@ -3,8 +3,16 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
-uniform mat4 model;
-uniform mat4 MVP;
+// 프레임 데이터 (shader_uniforms.h의 FrameUniforms, binding kFrameUniformBinding)
+layout (std140) uniform FrameData {
+    mat4 MVP;
+    mat4 model;
+    mat4 lightMVP;
+    vec3 lightPos;
+    vec3 viewPos;
+    vec2 viewportSize;      // framebuffer 크기 (pixel)
+    float pixelsPerUnit;    // 거리 1에서 길이 1이 차지하는 pixel 수
+};
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -24,6 +24,7 @@ uniform sampler2D marschnerTexture;
 uniform sampler2D NR_texture;
 uniform sampler2D NTT_texture;
 uniform sampler2D NTRT_texture;
+uniform vec3 absorption;        // sigma_a
 
 uniform sampler2D prevDepth;      //  ߰
 uniform vec2 screenSize;          //  ߰
@@ -52,8 +53,10 @@ void main(void) {
     vec2 texCoordAz = vec2(clamp((CosThetaD + 1.0) * 0.5, 0.0, 1.0), 
                            clamp((gsCosPhiD + 1.0) * 0.5, 0.0, 1.0));
     float NR = clamp(texture(NR_texture, texCoordAz).r, 0.0, 1.0);
-    vec3 NTT = clamp(texture(NTT_texture, texCoordAz).rgb, 0.0, 1.0);
-    vec3 NTRT = clamp(texture(NTRT_texture, texCoordAz).rgb, 0.0, 1.0);
+    vec2 tt = texture(NTT_texture, texCoordAz).rg;     // (A, L)
+    vec3 NTT = clamp(tt.x * exp(-absorption * tt.y), 0.0, 1.0);
+    vec2 trt = texture(NTRT_texture, texCoordAz).rg;
+    vec3 NTRT = clamp(trt.x * exp(-2.0 * absorption * trt.y), 0.0, 1.0);
 
     float cD2 = CosThetaD * CosThetaD;
     vec3 S = MR * NR * vec3(1.0) / cD2 
@@ -140,6 +140,34 @@ inline GLuint loadShaders(const char* vsFilename, const char* fsFilename, const
 
 	return programID;
 }
+// Compute shader (GL 4.3+). 컴파일/링크에 실패하면 0을 반환한다.
+inline GLuint loadComputeShader(const char* csFilename) {
+	std::string compCode = loadText(csFilename);
+	if (compCode.empty()) {
+		std::cerr << "[ERROR] Compute shader code is not loaded properly" << std::endl;
+		return 0;
+	}
+	GLuint compShaderID = glCreateShader(GL_COMPUTE_SHADER);
+	const GLchar* cshaderCode = compCode.c_str();
+	glShaderSource(compShaderID, 1, &cshaderCode, nullptr);
+	glCompileShader(compShaderID);
+	printInfoShaderLog(compShaderID);
+
+	GLuint programID = glCreateProgram();
+	glAttachShader(programID, compShaderID);
+	glLinkProgram(programID);
+	printInfoProgramLog(programID);
+	glDeleteShader(compShaderID);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		glDeleteProgram(programID);
+		return 0;
+	}
+	return programID;
+}
+
 inline GLuint createShaderProgram_Unlinked(const char* vsFilename, const char* fsFilename, const char* gsFilename = nullptr) {
 	GLuint vertShaderID = glCreateShader(GL_VERTEX_SHADER);
 	GLuint fragShaderID = glCreateShader(GL_FRAGMENT_SHADER);
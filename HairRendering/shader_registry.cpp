@@ -0,0 +1,373 @@
+﻿#include "shader_registry.h"
+#include "shader.h"
+#include "hair_pack.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+namespace {
+
+const uint32_t kProgramBinaryVersion = 1;
+
+struct ProgramBinaryHeader {
+    char magic[4];                  // "GLPB"
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t driverHash;
+    uint32_t format;
+    uint32_t length;
+    double compileMs;               // 이 binary를 만들 때 든 컴파일+링크 시간
+};
+static_assert(sizeof(ProgramBinaryHeader) == 40, "unexpected .glbin header padding");
+
+double nowSeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 없는 파일은 0
+int64_t fileModifiedTime(const string& filename) {
+    if (filename.empty()) return 0;
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(filename.c_str(), &st) != 0) return 0;
+#else
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return 0;
+#endif
+    return int64_t(st.st_mtime);
+}
+
+GLuint compileStage(GLenum type, const string& source) {
+    GLuint shader = glCreateShader(type);
+    const GLchar* code = source.c_str();
+    glShaderSource(shader, 1, &code, nullptr);
+    glCompileShader(shader);
+    printInfoShaderLog(shader);
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// 실행 폴더에 shader_<hash>.glbin (드라이버가 바뀌면 다른 파일)
+string programBinaryPath(uint64_t sourceHash, uint64_t driverHash) {
+    ostringstream name;
+    name << "shader_" << hex << (sourceHash ^ (driverHash * 31)) << ".glbin";
+    return name.str();
+}
+
+// 실패하면 0. retrievable이면 glGetProgramBinary로 꺼낼 수 있게 링크한다.
+GLuint linkProgram(const string sources[3], bool retrievable) {
+    static const GLenum types[3] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+    GLuint shaders[3] = {};
+    bool ok = true;
+    for (int i = 0; i < 3 && ok; ++i) {
+        if (i == 2 && sources[i].empty()) break;
+        shaders[i] = compileStage(types[i], sources[i]);
+        ok = shaders[i] != 0;
+    }
+
+    GLuint program = 0;
+    if (ok) {
+        program = glCreateProgram();
+        for (GLuint shader : shaders)
+            if (shader) glAttachShader(program, shader);
+        if (retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        printInfoProgramLog(program);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    for (GLuint shader : shaders)
+        if (shader) glDeleteShader(shader);
+    return program;
+}
+
+}
+
+ShaderHandle ShaderRegistry::load(const char* vsFilename, const char* fsFilename, const char* gsFilename) {
+    string files[3] = { vsFilename, fsFilename, gsFilename ? gsFilename : "" };
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (entry.files[0] == files[0] && entry.files[1] == files[1] && entry.files[2] == files[2])
+            return ShaderHandle(i);
+    }
+
+    Entry entry;
+    for (int i = 0; i < 3; ++i) {
+        entry.files[i] = files[i];
+        entry.mtimes[i] = fileModifiedTime(files[i]);
+    }
+    rebuild(entry);
+    entries.push_back(entry);
+    stats_.programs = int(entries.size());
+    return ShaderHandle(entries.size() - 1);
+}
+
+GLuint ShaderRegistry::program(ShaderHandle handle) const {
+    if (handle < 0 || size_t(handle) >= entries.size()) return 0;
+    return entries[handle].program;
+}
+
+unsigned ShaderRegistry::revision(ShaderHandle handle) const {
+    if (handle < 0 || size_t(handle) >= entries.size()) return 0;
+    return entries[handle].revision;
+}
+
+const ShaderUniforms& ShaderRegistry::uniforms(ShaderHandle handle) const {
+    static const ShaderUniforms empty;
+    if (handle < 0 || size_t(handle) >= entries.size()) return empty;
+    return entries[handle].uniforms;
+}
+
+void ShaderRegistry::bindUniformBlock(const char* name, GLuint binding) {
+    blockBindings.emplace_back(name, binding);
+}
+
+void ShaderRegistry::bindSampler(const char* name, int unit) {
+    samplerUnits.emplace_back(name, unit);
+}
+
+// sampler unit과 block binding은 program 상태라 링크할 때 한 번만 정하면 된다
+void ShaderRegistry::applyBindings(Entry& entry) {
+    entry.uniforms.reflect(entry.program);
+    if (!entry.program) return;
+    for (const auto& block : blockBindings)
+        entry.uniforms.bindBlock(block.first.c_str(), block.second);
+
+    GLint current = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+    glUseProgram(entry.program);
+    for (const auto& sampler : samplerUnits) {
+        GLint loc = glGetUniformLocation(entry.program, sampler.first.c_str());
+        if (loc >= 0) glUniform1i(loc, sampler.second);
+    }
+    glUseProgram(GLuint(current));
+}
+
+// 소스를 읽어서 hash가 같으면 그대로, 캐시에 있으면 재사용, 없으면 컴파일한다
+bool ShaderRegistry::rebuild(Entry& entry) {
+    string sources[3];
+    string joined;
+    for (int i = 0; i < 3; ++i) {
+        if (entry.files[i].empty()) continue;
+        sources[i] = loadText(entry.files[i]);
+        if (sources[i].empty()) {
+            stats_.failures++;
+            stats_.lastError = entry.files[i];
+            return false;
+        }
+        joined += entry.files[i];
+        joined += '\0';
+        joined += sources[i];
+        joined += '\0';
+    }
+    uint64_t hash = hashBytes(reinterpret_cast<const unsigned char*>(joined.data()), joined.size());
+    if (entry.program && hash == entry.sourceHash) return false;
+
+    GLuint program = 0;
+    auto cached = programsByHash.find(hash);
+    if (cached != programsByHash.end()) {
+        program = cached->second;
+        stats_.cacheHits++;
+    }
+    else {
+        bool useBinary = binaryCache && binaryCacheAvailable();
+        if (useBinary) program = loadBinary(hash);
+        if (!program) {
+            auto start = chrono::steady_clock::now();
+            program = linkProgram(sources, useBinary);
+            stats_.lastCompileMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            stats_.totalCompileMs += stats_.lastCompileMs;
+            stats_.compiles++;
+            if (!program) {
+                cerr << "[ERROR] Shader program " << entry.files[0] << " / " << entry.files[1]
+                     << " failed to build; keeping the previous program" << endl;
+                stats_.failures++;
+                stats_.lastError = entry.files[1];
+                return false;
+            }
+            if (useBinary) saveBinary(hash, program, stats_.lastCompileMs);
+        }
+        programsByHash[hash] = program;
+    }
+
+    GLuint previous = entry.program;
+    uint64_t previousHash = entry.sourceHash;
+    bool reloaded = previous != 0;
+    entry.program = program;
+    entry.sourceHash = hash;
+    entry.revision++;
+    applyBindings(entry);
+    if (reloaded) {
+        stats_.reloads++;
+        releaseUnused(previous);
+        removeUnusedBinary(previousHash);
+    }
+    return true;
+}
+
+bool ShaderRegistry::binaryCacheAvailable() {
+    if (binarySupport < 0) {
+        GLint formats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        binarySupport = formats > 0 ? 1 : 0;
+
+        // 드라이버가 바뀌면 binary를 쓸 수 없으므로 key에 넣는다
+        string driver;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            const GLubyte* value = glGetString(name);
+            if (value) driver += reinterpret_cast<const char*>(value);
+            driver += '\0';
+        }
+        driverHash = hashBytes(reinterpret_cast<const unsigned char*>(driver.data()), driver.size());
+    }
+    return binarySupport == 1;
+}
+
+// 캐시가 없거나 드라이버가 거부하면 0 (호출자는 소스에서 컴파일한다)
+GLuint ShaderRegistry::loadBinary(uint64_t sourceHash) {
+    string path = programBinaryPath(sourceHash, driverHash);
+    ifstream in(path, ios::binary);
+    if (!in) return 0;
+
+    ProgramBinaryHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return 0;
+    if (strncmp(header.magic, "GLPB", 4) != 0 || header.version != kProgramBinaryVersion ||
+        header.sourceHash != sourceHash || header.driverHash != driverHash)
+        return 0;
+    vector<char> binary(header.length);
+    if (!in.read(binary.data(), binary.size())) return 0;
+
+    auto start = chrono::steady_clock::now();
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), GLsizei(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (!linked) {
+        // 드라이버 업데이트 등으로 형식이 맞지 않으면 지우고 새로 만든다
+        glDeleteProgram(program);
+        remove(path.c_str());
+        stats_.binaryRejects++;
+        return 0;
+    }
+    stats_.binaryLoads++;
+    stats_.binaryLoadMs += loadMs;
+    stats_.savedCompileMs += header.compileMs;
+    return program;
+}
+
+void ShaderRegistry::saveBinary(uint64_t sourceHash, GLuint program, double compileMs) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramBinaryHeader header = {};
+    memcpy(header.magic, "GLPB", 4);
+    header.version = kProgramBinaryVersion;
+    header.sourceHash = sourceHash;
+    header.driverHash = driverHash;
+    header.format = format;
+    header.length = uint32_t(length);
+    header.compileMs = compileMs;
+
+    // marschner 캐시와 같이 임시 파일에 쓰고 교체
+    string path = programBinaryPath(sourceHash, driverHash);
+    string tempPath = path + ".tmp";
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), length);
+        if (!out) {
+            cerr << "Failed to write program binary: " << tempPath << endl;
+            return;
+        }
+    }
+    remove(path.c_str());
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return;
+    }
+    stats_.binaryWrites++;
+}
+
+// 다른 entry가 쓰지 않는 program은 지운다 (편집하는 동안 program이 쌓이지 않게)
+void ShaderRegistry::releaseUnused(GLuint program) {
+    for (const Entry& entry : entries)
+        if (entry.program == program) return;
+    for (auto it = programsByHash.begin(); it != programsByHash.end(); ++it) {
+        if (it->second == program) {
+            programsByHash.erase(it);
+            break;
+        }
+    }
+    glDeleteProgram(program);
+}
+
+// hot reload로 바뀐 소스의 binary는 다시 쓰이지 않으므로 지운다 (편집할 때마다 .glbin이 쌓이지 않게)
+void ShaderRegistry::removeUnusedBinary(uint64_t sourceHash) {
+    if (binarySupport != 1) return;
+    for (const Entry& entry : entries)
+        if (entry.sourceHash == sourceHash) return;
+    remove(programBinaryPath(sourceHash, driverHash).c_str());
+}
+
+int ShaderRegistry::update() {
+    double now = nowSeconds();
+    if (lastPoll >= 0.0 && now - lastPoll < pollSeconds) return 0;
+    lastPoll = now;
+
+    auto start = chrono::steady_clock::now();
+    int changed = 0;
+    for (Entry& entry : entries) {
+        bool modified = false;
+        for (int i = 0; i < 3; ++i) {
+            int64_t mtime = fileModifiedTime(entry.files[i]);
+            if (mtime != entry.mtimes[i]) {
+                entry.mtimes[i] = mtime;
+                modified = true;
+            }
+        }
+        if (modified && rebuild(entry)) changed++;
+    }
+    stats_.lastPollMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return changed;
+}
+
+int ShaderRegistry::reloadAll() {
+    int changed = 0;
+    for (Entry& entry : entries) {
+        for (int i = 0; i < 3; ++i)
+            entry.mtimes[i] = fileModifiedTime(entry.files[i]);
+        if (rebuild(entry)) changed++;
+    }
+    return changed;
+}
+
+void ShaderRegistry::release() {
+    for (auto& cached : programsByHash)
+        glDeleteProgram(cached.second);
+    programsByHash.clear();
+    entries.clear();
+    stats_ = ShaderRegistryStats();
+    lastPoll = -1.0;
+}
@@ -0,0 +1,100 @@
+﻿#ifndef SHADER_REGISTRY_H
+#define SHADER_REGISTRY_H
+
+#include <GL/glew.h>
+#include "shader_uniforms.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef int ShaderHandle;
+const ShaderHandle kInvalidShader = -1;
+
+struct ShaderRegistryStats {
+    int programs = 0;               // 등록된 (vs, fs, gs) 조합 수
+    int compiles = 0;               // 실제 컴파일+링크 횟수
+    int cacheHits = 0;              // 같은 소스 hash라 컴파일을 건너뛴 횟수
+    int reloads = 0;                // 파일이 바뀌어 새 program으로 바꾼 횟수
+    int failures = 0;               // 컴파일/링크 실패 (이전 program을 계속 쓴다)
+    double lastCompileMs = 0.0;     // 마지막 컴파일+링크 시간
+    double totalCompileMs = 0.0;
+    double lastPollMs = 0.0;        // 마지막 파일 시각 검사 시간
+    std::string lastError;          // 마지막 실패한 파일
+
+    // program binary 캐시 (shader_<hash>.glbin)
+    int binaryLoads = 0;            // 컴파일 없이 glProgramBinary로 읽은 수
+    int binaryRejects = 0;          // 드라이버가 거부해서 소스로 다시 컴파일한 수
+    int binaryWrites = 0;
+    double binaryLoadMs = 0.0;      // glProgramBinary에 쓴 시간 합
+    double savedCompileMs = 0.0;    // 읽은 binary를 만들 때 들었던 컴파일+링크 시간 합
+};
+
+// 셰이더 program을 한 번만 컴파일해서 들고 있는 registry.
+// 소스 hash로 캐시하고, 파일 수정 시각이 바뀐 program만 다시 컴파일한다 (hot reload).
+// 새 소스가 컴파일/링크에 실패하면 이전 program을 그대로 쓴다.
+class ShaderRegistry {
+public:
+    ShaderRegistry() = default;
+    ShaderRegistry(const ShaderRegistry&) = delete;
+    ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+    // 같은 파일 조합은 같은 handle. 처음 실패하면 program(handle)이 0이다.
+    ShaderHandle load(const char* vsFilename, const char* fsFilename, const char* gsFilename = nullptr);
+
+    GLuint program(ShaderHandle handle) const;
+
+    // program이 바뀔 때마다 증가 (uniform location 등을 다시 읽을 때 쓴다)
+    unsigned revision(ShaderHandle handle) const;
+
+    // 링크할 때 읽어 둔 uniform location
+    const ShaderUniforms& uniforms(ShaderHandle handle) const;
+
+    // 이후 링크되는 모든 program에 적용한다 (load 전에 부른다)
+    void bindUniformBlock(const char* name, GLuint binding);
+    void bindSampler(const char* name, int unit);
+
+    // pollSeconds마다 파일 시각을 검사한다. 매 프레임 불러도 된다. 새로 바뀐 program 수를 반환.
+    int update();
+
+    // 시각과 관계없이 모든 program을 다시 읽는다
+    int reloadAll();
+
+    const ShaderRegistryStats& stats() const { return stats_; }
+
+    void release();
+
+    double pollSeconds = 0.5;
+
+    // 링크한 program을 실행 폴더에 binary로 저장하고 다음 실행에서 읽는다 (GL 4.1 / ARB_get_program_binary)
+    bool binaryCache = true;
+
+private:
+    struct Entry {
+        std::string files[3];       // vs, fs, gs (gs는 비어 있을 수 있음)
+        int64_t mtimes[3] = {};
+        uint64_t sourceHash = 0;
+        GLuint program = 0;
+        unsigned revision = 0;
+        ShaderUniforms uniforms;
+    };
+
+    bool rebuild(Entry& entry);
+    void applyBindings(Entry& entry);
+    GLuint loadBinary(uint64_t sourceHash);
+    void saveBinary(uint64_t sourceHash, GLuint program, double compileMs);
+    bool binaryCacheAvailable();
+    void releaseUnused(GLuint program);
+    void removeUnusedBinary(uint64_t sourceHash);
+
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, GLuint> programsByHash;
+    std::vector<std::pair<std::string, GLuint>> blockBindings;
+    std::vector<std::pair<std::string, int>> samplerUnits;
+    double lastPoll = -1.0;
+    int binarySupport = -1;         // 처음 쓸 때 확인 (-1: 아직 모름)
+    uint64_t driverHash = 0;        // GL_VENDOR, GL_RENDERER, GL_VERSION
+    ShaderRegistryStats stats_;
+};
+
+#endif
@@ -0,0 +1,91 @@
+﻿#include "shader_uniforms.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+using namespace std;
+
+UniformCallStats uniformCallStats;
+bool uniformLookupEveryCall = false;
+
+void ShaderUniforms::reflect(GLuint program) {
+    program_ = program;
+    locations.clear();
+    if (!program) return;
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    vector<char> name(size_t(maxLength) + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, GLuint(i), GLsizei(name.size()), &length, &size, &type, name.data());
+        string uniformName(name.data(), size_t(length));
+        // block 멤버는 location이 -1
+        GLint loc = glGetUniformLocation(program, uniformName.c_str());
+        if (loc < 0) continue;
+        // 배열은 "name[0]"으로 나온다
+        size_t bracket = uniformName.find('[');
+        if (bracket != string::npos) uniformName.resize(bracket);
+        locations[uniformName] = loc;
+    }
+}
+
+GLint ShaderUniforms::location(const char* name) const {
+    if (uniformLookupEveryCall) {
+        uniformCallStats.locationQueries++;
+        return glGetUniformLocation(program_, name);
+    }
+    auto it = locations.find(name);
+    return it == locations.end() ? -1 : it->second;
+}
+
+void ShaderUniforms::set(const char* name, int value) const {
+    uniformCallStats.uniformCalls++;
+    glUniform1i(location(name), value);
+}
+
+void ShaderUniforms::set(const char* name, float value) const {
+    uniformCallStats.uniformCalls++;
+    glUniform1f(location(name), value);
+}
+
+void ShaderUniforms::set(const char* name, const glm::vec3& value) const {
+    uniformCallStats.uniformCalls++;
+    glUniform3fv(location(name), 1, glm::value_ptr(value));
+}
+
+void ShaderUniforms::set(const char* name, const glm::mat4& value) const {
+    uniformCallStats.uniformCalls++;
+    glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderUniforms::set(const char* name, const glm::vec4* values, int count) const {
+    uniformCallStats.uniformCalls++;
+    glUniform4fv(location(name), count, glm::value_ptr(values[0]));
+}
+
+void ShaderUniforms::bindBlock(const char* name, GLuint binding) const {
+    if (!program_) return;
+    GLuint index = glGetUniformBlockIndex(program_, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program_, index, binding);
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& frame) {
+    if (!buffer) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, kFrameUniformBinding, buffer);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uniformCallStats.bufferUploads++;
+}
+
+void FrameUniformBuffer::release() {
+    if (buffer) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
@@ -0,0 +1,78 @@
+﻿#ifndef SHADER_UNIFORMS_H
+#define SHADER_UNIFORMS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+
+// 프레임마다 드라이버에 보내는 uniform 관련 호출 수 (GUI 표시용, 프레임 시작에 0으로)
+struct UniformCallStats {
+    unsigned locationQueries = 0;   // glGetUniformLocation
+    unsigned uniformCalls = 0;      // glUniform*
+    unsigned bufferUploads = 0;     // UBO glBufferSubData
+};
+extern UniformCallStats uniformCallStats;
+
+// 비교용: 켜면 예전처럼 uniform을 쓸 때마다 glGetUniformLocation을 부른다
+extern bool uniformLookupEveryCall;
+
+// 링크 직후 program의 active uniform을 한 번 읽어 두고 이름으로 location을 찾는 wrapper.
+// 프레임 중에는 드라이버에 location을 묻지 않는다.
+class ShaderUniforms {
+public:
+    ShaderUniforms() = default;
+
+    void reflect(GLuint program);
+    GLuint program() const { return program_; }
+
+    // 없는 uniform이면 -1 (glUniform*이 무시한다)
+    GLint location(const char* name) const;
+
+    // program이 바인딩된 상태에서 호출
+    void set(const char* name, int value) const;
+    void set(const char* name, float value) const;
+    void set(const char* name, const glm::vec3& value) const;
+    void set(const char* name, const glm::mat4& value) const;
+    void set(const char* name, const glm::vec4* values, int count) const;
+
+    // uniform block이 있으면 binding point에 연결한다
+    void bindBlock(const char* name, GLuint binding) const;
+
+private:
+    GLuint program_ = 0;
+    std::unordered_map<std::string, GLint> locations;
+};
+
+// 모든 셰이더가 같은 binding에서 읽는 프레임 데이터 (std140, 셰이더의 FrameData block과 같은 배치)
+const GLuint kFrameUniformBinding = 0;
+
+struct FrameUniforms {
+    glm::mat4 MVP;
+    glm::mat4 model;
+    glm::mat4 lightMVP;
+    glm::vec3 lightPos;
+    float pad0 = 0.0f;
+    glm::vec3 viewPos;
+    float pad1 = 0.0f;
+    glm::vec2 viewportSize;
+    float pixelsPerUnit = 0.0f;
+    float pad2 = 0.0f;
+};
+static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms must match the std140 FrameData block");
+
+// FrameData UBO. 프레임마다 한 번 update()한다.
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer() = default;
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    void update(const FrameUniforms& frame);
+    void release();
+
+private:
+    GLuint buffer = 0;
+};
+
+#endif
@@ -0,0 +1,115 @@
+﻿#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent worker pool.
+// parallelFor는 호출한 스레드도 작업에 참여하므로, worker 안에서 다시 호출해도 멈추지 않는다.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        // 호출 스레드가 한 몫을 하므로 worker는 하나 적게 만든다
+        for (unsigned i = 1; i < threadCount; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // worker 수 + 호출 스레드
+    unsigned threadCount() const { return unsigned(workers.size()) + 1; }
+
+    // fn(begin, end)를 [0, count)의 grain 크기 구간마다 호출하고, 모두 끝날 때까지 기다린다.
+    // maxThreads가 0이 아니면 참여 스레드 수를 제한한다.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn, unsigned maxThreads = 0) {
+        if (count == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (count + grain - 1) / grain;
+
+        unsigned threads = threadCount();
+        if (maxThreads > 0) threads = std::min(threads, maxThreads);
+        size_t helpers = std::min<size_t>(threads - 1, chunks - 1);
+
+        if (helpers == 0) {
+            fn(0, count);
+            return;
+        }
+
+        struct Job {
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto job = std::make_shared<Job>();
+
+        auto run = [job, count, grain, chunks, &fn] {
+            size_t chunk;
+            while ((chunk = job->next.fetch_add(1)) < chunks) {
+                size_t begin = chunk * grain;
+                fn(begin, std::min(begin + grain, count));
+                if (job->done.fetch_add(1) + 1 == chunks) {
+                    std::lock_guard<std::mutex> lock(job->mutex);
+                    job->finished.notify_all();
+                }
+            }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i) tasks.emplace_back(run);
+        }
+        wake.notify_all();
+
+        run();
+
+        // 늦게 시작한 helper는 남은 chunk가 없으면 fn을 건드리지 않고 바로 끝난다
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&] { return job->done.load() == chunks; });
+    }
+
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+#endif